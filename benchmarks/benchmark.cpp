@@ -0,0 +1,499 @@
+//
+// Microbenchmarks of the core: layer and net passes over a sweep of topologies, training data
+// parsing and whole training epochs, with heap allocations counted.
+//
+// Usage (from the project root, so data/xor.txt and data/digits.txt are found):
+//   ./Benchmark                                  # every benchmark, table on stdout
+//   ./Benchmark --quick --json results.json      # shorter runs, JSON for PerfCheck
+//   ./Benchmark --filter trainBatch              # only benchmarks whose name contains the text
+//
+// Options: --repetitions N (trials per benchmark, default 5), --min-time MS (least duration of a
+// trial, default 100; --quick sets 20 and 3 trials), --filter TEXT, --json FILE ("-" = stdout),
+// --pin CPU (run on that CPU only, which steadies the timings; Linux only).
+//
+// Every benchmark is calibrated so one trial runs at least --min-time, then timed in
+// --repetitions trials; the table shows the median. Rates are per sample: ns/sample,
+// samples/s and GFLOP/s, where a forward pass counts 2 flops per weight and training 6
+// (forward, input gradients, weight gradients; the update is not counted). allocs/sample counts
+// calls of operator new during the timed trials, which should be 0 for every steady-state path.
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "Arena.h"
+#include "Dataset.h"
+#include "DenseLayer.h"
+#include "Kernels.h"
+#include "Net.h"
+#include "Trainer.h"
+#include "TrainingData.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Every heap allocation of the process goes through these, so the benchmarks can count them.
+namespace {
+std::atomic<std::uint64_t> allocationCount{0};
+
+void *allocate(const std::size_t size, const std::size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void *p = alignment <= alignof(std::max_align_t)
+        ? std::malloc(size == 0 ? 1 : size)
+        : std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+}
+
+void *operator new(const std::size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void *operator new[](const std::size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::vector<std::vector<unsigned>> topologies = {
+    {2, 4, 1},          // XOR
+    {64, 32, 10},       // digits
+    {64, 128, 64, 10},
+    {256, 256, 10},
+    {784, 512, 10},     // MNIST-sized
+};
+
+constexpr std::size_t predictBatchSize = 64;
+constexpr std::size_t trainingBatchSize = 32;
+
+struct Options {
+    std::size_t repetitions = 5;
+    std::chrono::milliseconds minTime{100};
+    std::string filter;
+    std::string jsonFile;
+    int pinnedCpu = -1;
+};
+
+struct Result {
+    std::string name;      // unique: group/topology/precision/batch
+    std::string group;
+    std::string topology;
+    std::string precision;
+    std::size_t batchSize = 1;
+    double flopsPerSample = 0.0;
+    double allocationsPerSample = 0.0;
+    std::vector<double> trials; // ns per sample, one per trial
+
+    [[nodiscard]] double median() const {
+        std::vector<double> sorted = trials;
+        std::sort(sorted.begin(), sorted.end());
+        const std::size_t n = sorted.size();
+        return n % 2 == 1 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+};
+
+std::string topologyName(const std::vector<unsigned> &topology) {
+    std::string name;
+    for (const unsigned count : topology) {
+        name += (name.empty() ? "" : "-") + std::to_string(count);
+    }
+    return name;
+}
+
+// flops of one forward pass (2 per weight: multiply and add)
+double forwardFlops(const std::vector<unsigned> &topology) {
+    double flops = 0.0;
+    for (std::size_t l = 0; l + 1 < topology.size(); ++l) {
+        flops += 2.0 * topology[l] * topology[l + 1];
+    }
+    return flops;
+}
+
+// random values in [-1, 1], the same in every run
+template<typename T>
+std::vector<T> randomValues(const std::size_t count, const std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<T> values(count);
+    for (T &value : values) {
+        value = static_cast<T>(distribution(rng));
+    }
+    return values;
+}
+
+class Runner {
+public:
+    explicit Runner(const Options &options) : m_options(options) {}
+
+    // Times one benchmark; body(iterations) does the work iterations times and returns the
+    // number of samples it processed.
+    template<typename Body>
+    void run(const std::string &group, const std::string &topology, const std::string &precision,
+             const std::size_t batchSize, const double flopsPerSample, Body body) {
+        Result result;
+        result.group = group;
+        result.topology = topology;
+        result.precision = precision;
+        result.batchSize = batchSize;
+        result.flopsPerSample = flopsPerSample;
+        result.name = group + "/" + topology + "/" + precision + "/b" + std::to_string(batchSize);
+        if (!m_options.filter.empty() && result.name.find(m_options.filter) == std::string::npos) {
+            return;
+        }
+
+        // calibration, which also warms up caches, the kernel dispatch and thread-local buffers
+        std::size_t iterations = 1;
+        for (;;) {
+            const Clock::time_point start = Clock::now();
+            body(iterations);
+            const auto elapsed = Clock::now() - start;
+            if (elapsed >= m_options.minTime || iterations >= (std::size_t{1} << 40)) {
+                break;
+            }
+            const double ratio = std::chrono::duration<double>(m_options.minTime).count() /
+                                 std::max(std::chrono::duration<double>(elapsed).count(), 1e-9);
+            iterations = std::max(iterations * 2, static_cast<std::size_t>(static_cast<double>(iterations) * ratio * 1.1));
+        }
+
+        std::uint64_t samples = 0;
+        result.trials.reserve(m_options.repetitions);
+        const std::uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        for (std::size_t trial = 0; trial < m_options.repetitions; ++trial) {
+            const Clock::time_point start = Clock::now();
+            const std::size_t trialSamples = body(iterations);
+            const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            result.trials.push_back(ns / static_cast<double>(trialSamples));
+            samples += trialSamples;
+        }
+        const std::uint64_t allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        result.allocationsPerSample = static_cast<double>(allocations) / static_cast<double>(samples);
+
+        print(result);
+        m_results.push_back(std::move(result));
+    }
+
+    [[nodiscard]] const std::vector<Result> &getResults() const { return m_results; }
+
+private:
+    static void print(const Result &result) {
+        const double ns = result.median();
+        std::cout << std::left << std::setw(44) << result.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << ns
+                  << std::setprecision(0) << std::setw(14) << 1e9 / ns
+                  << std::setprecision(2) << std::setw(10) << result.flopsPerSample / ns
+                  << std::setprecision(3) << std::setw(10) << result.allocationsPerSample << "\n"
+                  << std::defaultfloat << std::flush;
+    }
+
+    Options m_options;
+    std::vector<Result> m_results;
+};
+
+// one dense layer of the topology's first shape, one sample at a time
+template<typename T>
+void benchmarkLayer(Runner &runner, const std::vector<unsigned> &topology, const char *precision) {
+    DenseLayer<T> layer(topology[0], topology[1]);
+    Arena arena(DenseLayer<T>::arenaBytes(topology[0], topology[1], 1, false));
+    layer.place(arena, 1, false);
+    const std::vector<double> weights = randomValues<double>(std::size_t{topology[0]} * topology[1], 1);
+    const std::vector<double> biases = randomValues<double>(topology[1], 2);
+    layer.setParameters(weights.data(), biases.data());
+    const std::vector<T> inputs = randomValues<T>(topology[0], 3);
+
+    const std::string shape = std::to_string(topology[0]) + "-" + std::to_string(topology[1]);
+    runner.run("layer.feedForward", shape, precision, 1, 2.0 * topology[0] * topology[1],
+               [&](const std::size_t iterations) {
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       layer.feedForward(inputs);
+                   }
+                   return iterations;
+               });
+}
+
+// the single-sample API: feedForward, and feedForward + backPropagate
+void benchmarkNetSingle(Runner &runner, const std::vector<unsigned> &topology) {
+    Net net(topology);
+    const std::vector<double> inputs = randomValues<double>(topology.front(), 4);
+    const std::vector<double> targets = randomValues<double>(topology.back(), 5);
+    const std::string name = topologyName(topology);
+
+    runner.run("net.feedForward", name, "double", 1, forwardFlops(topology),
+               [&](const std::size_t iterations) {
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       net.feedForward(inputs);
+                   }
+                   return iterations;
+               });
+    runner.run("net.backPropagate", name, "double", 1, 3.0 * forwardFlops(topology),
+               [&](const std::size_t iterations) {
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       net.feedForward(inputs);
+                       net.backPropagate(targets);
+                   }
+                   return iterations;
+               });
+}
+
+// the batched API: predict and trainBatch
+template<typename T>
+void benchmarkNetBatch(Runner &runner, const std::vector<unsigned> &topology, const char *precision) {
+    BasicNet<T> net(topology);
+    const std::string name = topologyName(topology);
+    const std::vector<T> inputs = randomValues<T>(predictBatchSize * topology.front(), 6);
+    std::vector<T> outputs(predictBatchSize * topology.back());
+    const std::vector<float> trainingInputs = randomValues<float>(trainingBatchSize * topology.front(), 7);
+    const std::vector<float> trainingTargets = randomValues<float>(trainingBatchSize * topology.back(), 8);
+
+    runner.run("net.predict", name, precision, predictBatchSize, forwardFlops(topology),
+               [&](const std::size_t iterations) {
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       net.predict(inputs.data(), predictBatchSize, outputs.data());
+                   }
+                   return iterations * predictBatchSize;
+               });
+    runner.run("net.trainBatch", name, precision, trainingBatchSize, 3.0 * forwardFlops(topology),
+               [&](const std::size_t iterations) {
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       net.trainBatch(trainingInputs.data(), trainingTargets.data(), trainingBatchSize);
+                   }
+                   return iterations * trainingBatchSize;
+               });
+}
+
+// reading a text file through TrainingData (sample by sample) and Dataset::load (chunked)
+void benchmarkParsing(Runner &runner, const std::string &filename) {
+    if (!std::filesystem::exists(filename)) {
+        std::cerr << "Skipping parsing of " << filename << ": not found (run from the project root)" << std::endl;
+        return;
+    }
+    std::vector<unsigned> topology;
+    TrainingData(filename).getTopology(topology);
+    const std::string name = std::filesystem::path(filename).stem().string();
+
+    runner.run("parse.TrainingData", name, "double", 1, 0.0,
+               [&](const std::size_t iterations) {
+                   std::size_t samples = 0;
+                   std::vector<double> inputVals, targetVals;
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       TrainingData trainingData(filename);
+                       std::vector<unsigned> fileTopology;
+                       trainingData.getTopology(fileTopology);
+                       while (trainingData.getNextInputs(inputVals) == topology.front() &&
+                              trainingData.getTargetOutputs(targetVals) == topology.back()) {
+                           ++samples;
+                       }
+                   }
+                   return samples;
+               });
+    runner.run("parse.Dataset", name, "float", 1, 0.0,
+               [&](const std::size_t iterations) {
+                   std::size_t samples = 0;
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       samples += Dataset::load(filename).getSampleCount();
+                   }
+                   return samples;
+               });
+}
+
+// whole epochs through Trainer, as the CLI and the GUI run them
+template<typename T>
+void benchmarkEpochs(Runner &runner, const std::string &filename, const std::size_t batchSize, const char *precision) {
+    if (!std::filesystem::exists(filename)) {
+        std::cerr << "Skipping epochs on " << filename << ": not found (run from the project root)" << std::endl;
+        return;
+    }
+    const Dataset dataset = Dataset::load(filename);
+    BasicNet<T> net(dataset.getTopology());
+    TrainingOptions options;
+    options.batchSize = batchSize;
+    Trainer trainer(options);
+
+    const std::string group = "epoch." + std::filesystem::path(filename).stem().string();
+    runner.run(group, topologyName(dataset.getTopology()), precision, batchSize, 3.0 * forwardFlops(dataset.getTopology()),
+               [&](const std::size_t iterations) {
+                   std::size_t samples = 0;
+                   for (std::size_t i = 0; i < iterations; ++i) {
+                       samples += trainer.train(net, dataset).progress.samples;
+                   }
+                   return samples;
+               });
+}
+
+std::string jsonString(const std::string &text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// the machine the results come from; PerfCheck only compares results of the same one
+std::string hostName() {
+#ifdef _WIN32
+    const char *name = std::getenv("COMPUTERNAME");
+    return name ? name : "";
+#else
+    char name[256] = {};
+    return gethostname(name, sizeof(name) - 1) == 0 ? name : "";
+#endif
+}
+
+void writeJson(std::ostream &out, const Options &options, const std::vector<Result> &results) {
+    out << std::setprecision(10) << "{\n"
+        << "  \"version\": 1,\n"
+        << "  \"host\": " << jsonString(hostName()) << ",\n"
+        << "  \"isa\": " << jsonString(kernels::activeIsa()) << ",\n"
+        << "  \"repetitions\": " << options.repetitions << ",\n"
+        << "  \"min_time_ms\": " << options.minTime.count() << ",\n"
+        << "  \"pinned_cpu\": " << options.pinnedCpu << ",\n"
+        << "  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result &result = results[i];
+        const double ns = result.median();
+        out << "    {\"name\": " << jsonString(result.name)
+            << ", \"group\": " << jsonString(result.group)
+            << ", \"topology\": " << jsonString(result.topology)
+            << ", \"precision\": " << jsonString(result.precision)
+            << ", \"batch\": " << result.batchSize
+            << ", \"ns_per_sample\": " << ns
+            << ", \"samples_per_second\": " << 1e9 / ns
+            << ", \"gflops\": " << result.flopsPerSample / ns
+            << ", \"allocations_per_sample\": " << result.allocationsPerSample
+            << ", \"trials_ns_per_sample\": [";
+        for (std::size_t t = 0; t < result.trials.size(); ++t) {
+            out << (t == 0 ? "" : ", ") << result.trials[t];
+        }
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// keeps the process on one CPU, so the scheduler cannot move it between cores (and caches) in
+// the middle of a trial; returns false where that is not supported
+bool pinToCpu(const std::size_t cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void) cpu;
+    return false;
+#endif
+}
+
+std::size_t parseCount(const std::string &option, const char *text, const std::size_t minimum = 1) {
+    char *end = nullptr;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || value < minimum) {
+        throw std::invalid_argument("Invalid value for " + option + ": " + text);
+    }
+    return static_cast<std::size_t>(value);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string option = argv[i];
+            if (option == "--quick") {
+                options.repetitions = 3;
+                options.minTime = std::chrono::milliseconds(20);
+            } else if (i + 1 < argc && option == "--repetitions") {
+                options.repetitions = parseCount(option, argv[++i]);
+            } else if (i + 1 < argc && option == "--min-time") {
+                options.minTime = std::chrono::milliseconds(parseCount(option, argv[++i]));
+            } else if (i + 1 < argc && option == "--filter") {
+                options.filter = argv[++i];
+            } else if (i + 1 < argc && option == "--json") {
+                options.jsonFile = argv[++i];
+            } else if (i + 1 < argc && option == "--pin") {
+                options.pinnedCpu = static_cast<int>(parseCount(option, argv[++i], 0));
+            } else {
+                std::cerr << "Usage: " << argv[0]
+                          << " [--quick] [--repetitions N] [--min-time MS] [--filter TEXT] [--json FILE|-] [--pin CPU]" << std::endl;
+                return 1;
+            }
+        }
+
+        if (options.pinnedCpu >= 0 && !pinToCpu(static_cast<std::size_t>(options.pinnedCpu))) {
+            std::cerr << "Warning: cannot pin to CPU " << options.pinnedCpu << ", running unpinned" << std::endl;
+            options.pinnedCpu = -1;
+        }
+
+        // with the JSON on stdout the table goes to stderr
+        std::ostream &table = options.jsonFile == "-" ? std::cerr : std::cout;
+        std::streambuf *const stdoutBuffer = std::cout.rdbuf();
+        if (options.jsonFile == "-") {
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
+        table << "Kernels: " << kernels::activeIsa() << ", " << options.repetitions << " trials of at least "
+              << options.minTime.count() << " ms, median shown"
+              << (options.pinnedCpu >= 0 ? ", pinned to CPU " + std::to_string(options.pinnedCpu) : std::string()) << "\n"
+              << std::left << std::setw(44) << "benchmark" << std::right << std::setw(12) << "ns/sample"
+              << std::setw(14) << "samples/s" << std::setw(10) << "GFLOP/s" << std::setw(10) << "allocs" << "\n";
+
+        Runner runner(options);
+        for (const std::vector<unsigned> &topology : topologies) {
+            benchmarkLayer<double>(runner, topology, "double");
+            benchmarkLayer<float>(runner, topology, "float");
+            benchmarkNetSingle(runner, topology);
+            benchmarkNetBatch<double>(runner, topology, "double");
+            benchmarkNetBatch<float>(runner, topology, "float");
+        }
+        for (const std::string filename : {"data/xor.txt", "data/digits.txt"}) {
+            benchmarkParsing(runner, filename);
+        }
+        benchmarkEpochs<double>(runner, "data/xor.txt", 1, "double");
+        benchmarkEpochs<double>(runner, "data/digits.txt", 1, "double");
+        benchmarkEpochs<double>(runner, "data/digits.txt", trainingBatchSize, "double");
+        benchmarkEpochs<float>(runner, "data/digits.txt", trainingBatchSize, "float");
+        std::cout.rdbuf(stdoutBuffer);
+
+        if (options.jsonFile == "-") {
+            writeJson(std::cout, options, runner.getResults());
+        } else if (!options.jsonFile.empty()) {
+            std::ofstream out(options.jsonFile);
+            writeJson(out, options, runner.getResults());
+            if (!out) {
+                throw std::runtime_error("Cannot write " + options.jsonFile);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,426 @@
+//
+// Compares Benchmark results against a baseline and fails on performance regressions.
+//
+// Usage:
+//   ./PerfCheck benchmarks/baseline.json results.json [--threshold 0.15] [--sigmas 3]
+//               [--noise-floor 0.05] [--rerun "COMMAND"] [--any-host]
+//
+// Both files are written by Benchmark --json. For every benchmark in both, the medians of the
+// per-trial ns/sample are compared. A benchmark has regressed if it is slower by more than the
+// threshold (relative) and the slowdown is also larger than --sigmas times the combined noise of
+// the two runs, estimated from the median absolute deviation (MAD) of their trials; so a noisy
+// benchmark needs a larger slowdown to fail. A handful of trials can agree by chance, so the
+// noise is taken to be at least --noise-floor of the baseline. A benchmark that allocated nothing
+// per sample in the baseline also fails if it allocates now. Exits with 1 if anything regressed.
+//
+// With --rerun, every benchmark that looks slower is timed twice more with
+// COMMAND --filter NAME --json FILE (COMMAND being a Benchmark invocation), and only counts as a
+// regression if it is slower in both reruns too; a one-off hiccup of the machine does not fail.
+//
+// Baselines only compare on the machine (and kernel ISA) they were recorded on, so results from
+// another host are refused unless --any-host is given: record one with the perf-baseline target,
+// check with the perf-check target.
+//
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// scales a MAD to the standard deviation of normally distributed values
+constexpr double madToSigma = 1.4826;
+// allocations per sample a benchmark may gain before it counts as allocating
+constexpr double allocationTolerance = 0.01;
+// further runs a slower benchmark must also be slower in with --rerun
+constexpr int confirmationRuns = 2;
+
+// Just enough JSON for Benchmark's output: objects, arrays, strings without escapes other than
+// \" and \\, numbers, true, false and null.
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    [[nodiscard]] const JsonValue *find(const std::string &key) const {
+        for (const auto &[name, value] : object) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(std::string text) : m_text(std::move(text)) {}
+
+    JsonValue parse() {
+        JsonValue value = parseValue();
+        skipSpace();
+        if (m_pos != m_text.size()) {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string &what) const {
+        throw std::runtime_error("Invalid JSON at offset " + std::to_string(m_pos) + ": " + what);
+    }
+
+    void skipSpace() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+            ++m_pos;
+        }
+    }
+
+    bool consume(const char c) {
+        skipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const char c) {
+        if (!consume(c)) {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    bool consumeWord(const std::string &word) {
+        if (m_text.compare(m_pos, word.size(), word) == 0) {
+            m_pos += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string result;
+        while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+            if (m_text[m_pos] == '\\') {
+                ++m_pos;
+                if (m_pos == m_text.size()) break;
+            }
+            result += m_text[m_pos++];
+        }
+        expect('"');
+        return result;
+    }
+
+    JsonValue parseValue() {
+        skipSpace();
+        if (m_pos == m_text.size()) {
+            fail("unexpected end");
+        }
+        JsonValue value;
+        const char c = m_text[m_pos];
+        if (c == '{') {
+            value.type = JsonValue::Type::Object;
+            ++m_pos;
+            if (!consume('}')) {
+                do {
+                    std::string key = parseString();
+                    expect(':');
+                    value.object.emplace_back(std::move(key), parseValue());
+                } while (consume(','));
+                expect('}');
+            }
+        } else if (c == '[') {
+            value.type = JsonValue::Type::Array;
+            ++m_pos;
+            if (!consume(']')) {
+                do {
+                    value.array.push_back(parseValue());
+                } while (consume(','));
+                expect(']');
+            }
+        } else if (c == '"') {
+            value.type = JsonValue::Type::String;
+            value.string = parseString();
+        } else if (consumeWord("true") || consumeWord("false")) {
+            value.type = JsonValue::Type::Bool;
+            value.boolean = c == 't';
+        } else if (consumeWord("null")) {
+            value.type = JsonValue::Type::Null;
+        } else {
+            const char *begin = m_text.c_str() + m_pos;
+            char *end = nullptr;
+            value.type = JsonValue::Type::Number;
+            value.number = std::strtod(begin, &end);
+            if (end == begin) {
+                fail("unexpected character");
+            }
+            m_pos += static_cast<std::size_t>(end - begin);
+        }
+        return value;
+    }
+
+    std::string m_text;
+    std::size_t m_pos = 0;
+};
+
+struct Measurement {
+    std::vector<double> trials; // ns per sample
+    double allocationsPerSample = 0.0;
+};
+
+struct Results {
+    std::string host;
+    std::string isa;
+    std::map<std::string, Measurement> benchmarks;
+};
+
+double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const std::size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+// median absolute deviation from the median
+double mad(const std::vector<double> &values) {
+    const double center = median(values);
+    std::vector<double> deviations;
+    deviations.reserve(values.size());
+    for (const double value : values) {
+        deviations.push_back(std::abs(value - center));
+    }
+    return median(deviations);
+}
+
+Results loadResults(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + filename);
+    }
+    const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const JsonValue root = JsonParser(text).parse();
+    const JsonValue *benchmarks = root.find("benchmarks");
+    if (benchmarks == nullptr || benchmarks->type != JsonValue::Type::Array) {
+        throw std::runtime_error(filename + " has no benchmarks array; is it Benchmark --json output?");
+    }
+
+    Results results;
+    if (const JsonValue *host = root.find("host")) {
+        results.host = host->string;
+    }
+    if (const JsonValue *isa = root.find("isa")) {
+        results.isa = isa->string;
+    }
+    for (const JsonValue &benchmark : benchmarks->array) {
+        const JsonValue *name = benchmark.find("name");
+        const JsonValue *trials = benchmark.find("trials_ns_per_sample");
+        if (name == nullptr || trials == nullptr || trials->array.empty()) {
+            throw std::runtime_error(filename + " has a benchmark without name or trials");
+        }
+        Measurement measurement;
+        for (const JsonValue &trial : trials->array) {
+            measurement.trials.push_back(trial.number);
+        }
+        if (const JsonValue *allocations = benchmark.find("allocations_per_sample")) {
+            measurement.allocationsPerSample = allocations->number;
+        }
+        results.benchmarks[name->string] = std::move(measurement);
+    }
+    return results;
+}
+
+double parseValue(const std::string &option, const char *text) {
+    char *end = nullptr;
+    const double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || value < 0.0) {
+        throw std::invalid_argument("Invalid value for " + option + ": " + text);
+    }
+    return value;
+}
+
+struct Settings {
+    double threshold = 0.15;
+    double sigmas = 3.0;
+    double noiseFloor = 0.05;
+};
+
+struct Comparison {
+    double baseNs = 0.0;
+    double currentNs = 0.0;
+    double change = 0.0; // relative to the baseline
+    double noise = 0.0;  // ns
+    bool slower = false;
+    bool faster = false;
+};
+
+Comparison compare(const Measurement &before, const Measurement &now, const Settings &settings) {
+    Comparison result;
+    result.baseNs = median(before.trials);
+    result.currentNs = median(now.trials);
+    const double baseSigma = madToSigma * mad(before.trials);
+    const double currentSigma = madToSigma * mad(now.trials);
+    result.noise = std::max(std::sqrt(baseSigma * baseSigma + currentSigma * currentSigma),
+                            settings.noiseFloor * result.baseNs);
+    result.change = result.currentNs / result.baseNs - 1.0;
+    const double difference = result.currentNs - result.baseNs;
+    result.slower = result.change > settings.threshold && difference > settings.sigmas * result.noise;
+    result.faster = -result.change > settings.threshold && -difference > settings.sigmas * result.noise;
+    return result;
+}
+
+// times one benchmark again with the --rerun command; nullopt if the run did not produce it
+std::optional<Measurement> rerun(const std::string &command, const std::string &name, const std::string &file) {
+#ifdef _WIN32
+    const char *discard = " > NUL";
+#else
+    const char *discard = " > /dev/null";
+#endif
+    const std::string line = command + " --filter \"" + name + "\" --json \"" + file + "\"" + discard;
+    if (std::system(line.c_str()) != 0) {
+        throw std::runtime_error("Rerun failed: " + line);
+    }
+    const Results results = loadResults(file);
+    const auto found = results.benchmarks.find(name);
+    if (found == results.benchmarks.end()) {
+        return std::nullopt;
+    }
+    return found->second;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    Settings settings;
+    std::string rerunCommand;
+    bool anyHost = false;
+    std::vector<std::string> files;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string option = argv[i];
+            if (i + 1 < argc && option == "--threshold") {
+                settings.threshold = parseValue(option, argv[++i]);
+            } else if (i + 1 < argc && option == "--sigmas") {
+                settings.sigmas = parseValue(option, argv[++i]);
+            } else if (i + 1 < argc && option == "--noise-floor") {
+                settings.noiseFloor = parseValue(option, argv[++i]);
+            } else if (i + 1 < argc && option == "--rerun") {
+                rerunCommand = argv[++i];
+            } else if (option == "--any-host") {
+                anyHost = true;
+            } else if (option.starts_with("--")) {
+                files.clear();
+                break;
+            } else {
+                files.push_back(option);
+            }
+        }
+        if (files.size() != 2) {
+            std::cerr << "Usage: " << argv[0] << " <baseline.json> <results.json> [--threshold 0.15] [--sigmas 3]"
+                      << " [--noise-floor 0.05] [--rerun \"COMMAND\"] [--any-host]" << std::endl;
+            return 1;
+        }
+
+        const Results baseline = loadResults(files[0]);
+        const Results current = loadResults(files[1]);
+        if (baseline.host != current.host) {
+            const std::string recordedOn = baseline.host.empty() ? "an unknown machine" : baseline.host;
+            if (!anyHost) {
+                std::cerr << files[0] << " was recorded on " << recordedOn << ", not on this machine ("
+                          << current.host << "); timings of different machines do not compare. Record a "
+                          << "baseline here with the perf-baseline target, or pass --any-host." << std::endl;
+                return 1;
+            }
+            std::cout << "Warning: the baseline was recorded on " << recordedOn << ", these results on "
+                      << current.host << "; timings are not comparable\n";
+        }
+        if (baseline.isa != current.isa) {
+            std::cout << "Warning: the baseline ran on " << baseline.isa << " kernels, these results on "
+                      << current.isa << "; timings are not comparable\n";
+        }
+        const std::string rerunFile = files[1] + ".rerun.json";
+
+        std::size_t regressions = 0, improvements = 0, compared = 0, notReproduced = 0;
+        std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(12) << "baseline"
+                  << std::setw(12) << "current" << std::setw(9) << "change" << std::setw(9) << "noise" << "  status\n";
+        for (const auto &[name, now] : current.benchmarks) {
+            const auto found = baseline.benchmarks.find(name);
+            if (found == baseline.benchmarks.end()) {
+                std::cout << std::left << std::setw(44) << name << std::right << "  (not in the baseline)\n";
+                continue;
+            }
+            const Measurement &before = found->second;
+            ++compared;
+
+            const Comparison comparison = compare(before, now, settings);
+            bool slower = comparison.slower;
+            bool reproduced = true;
+            // the slowdown has to show up again, or it was the machine
+            for (int run = 0; slower && !rerunCommand.empty() && run < confirmationRuns; ++run) {
+                const std::optional<Measurement> again = rerun(rerunCommand, name, rerunFile);
+                if (!again || !compare(before, *again, settings).slower) {
+                    slower = false;
+                    reproduced = false;
+                }
+            }
+            const bool allocates = before.allocationsPerSample == 0.0 && now.allocationsPerSample > allocationTolerance;
+
+            std::string status = slower ? "REGRESSION" : !reproduced ? "ok (not reproduced)"
+                               : comparison.faster ? "faster" : "ok";
+            if (allocates) {
+                status = slower ? "REGRESSION, ALLOCATES" : "ALLOCATES";
+            }
+            if (slower || allocates) {
+                ++regressions;
+            } else if (comparison.faster) {
+                ++improvements;
+            }
+            if (!reproduced) {
+                ++notReproduced;
+            }
+
+            std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << comparison.baseNs << std::setw(12) << comparison.currentNs
+                      << std::showpos << std::setw(8) << comparison.change * 100.0 << "%" << std::noshowpos
+                      << std::setw(8) << comparison.noise / comparison.baseNs * 100.0 << "%"
+                      << "  " << status << "\n" << std::defaultfloat << std::setprecision(6);
+        }
+        for (const auto &[name, measurement] : baseline.benchmarks) {
+            if (!current.benchmarks.contains(name)) {
+                std::cout << std::left << std::setw(44) << name << std::right << "  (not run)\n";
+            }
+        }
+        std::remove(rerunFile.c_str()); // left by --rerun, if anything was rerun
+
+        std::cout << compared << " compared, " << regressions << " regressed, " << improvements << " faster";
+        if (notReproduced > 0) {
+            std::cout << ", " << notReproduced << " slower once but not on rerun";
+        }
+        std::cout << " (threshold " << settings.threshold * 100.0 << "%, " << settings.sigmas << " sigma, noise at least "
+                  << settings.noiseFloor * 100.0 << "%)" << std::endl;
+        return regressions > 0 ? 1 : 0;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
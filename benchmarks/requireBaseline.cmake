@@ -0,0 +1,15 @@
+# Run by the perf-check target before benchmarking: stops with an explanation when there is no
+# baseline, or when it was recorded on another machine (whose timings do not compare).
+#   cmake -DBASELINE=benchmarks/baseline.json -P benchmarks/requireBaseline.cmake
+if(NOT EXISTS "${BASELINE}")
+    message(FATAL_ERROR "No performance baseline at ${BASELINE}. Record one on this machine with "
+                        "the perf-baseline target (on a quiet machine, pinned runs), then run perf-check.")
+endif()
+
+file(READ "${BASELINE}" baseline)
+string(REGEX MATCH "\"host\": \"([^\"]*)\"" host_field "${baseline}")
+cmake_host_system_information(RESULT this_host QUERY HOSTNAME)
+if(NOT CMAKE_MATCH_1 STREQUAL this_host)
+    message(FATAL_ERROR "${BASELINE} was not recorded on this machine (${this_host}); timings of "
+                        "different machines do not compare. Record a baseline here with the perf-baseline target.")
+endif()
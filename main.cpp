@@ -1,86 +1,408 @@
-#include <cassert>
+//
+// Command-line trainer: trains a net on a data file at full speed, for scripts and batch jobs.
+//
+// Usage:
+//   ./NeuralNetCLI                                                    # XOR, one pass over data/xor.txt
+//   ./NeuralNetCLI --data data/digits.txt --epochs 30 --batch 32 --optimizer adam --lr 0.003 --save-model digits.nnm
+//   ./NeuralNetCLI --data data/digits.bin --topology 64,32,10 --threads 0 --validation 0.2 --patience 5
+//   ./NeuralNetCLI --data data/digits.txt --batch 32 --profile profile.json --trace trace.json
+//
+// Run with --help for all options. Progress goes to stdout, one line per --log-every epochs,
+// followed by a summary; errors go to stderr with exit code 1.
+//
+#include <algorithm>
+#include <charconv>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
+#include "Activation.h"
+#include "BinaryDataset.h"
+#include "Dataset.h"
+#include "LearningRateSchedule.h"
 #include "Net.h"
-#include "TrainingData.h"
+#include "Optimizer.h"
+#include "Trainer.h"
 
-// The command for listing all file in the terminal is: ls -a
-// if you only want to see files with a specific ending, e.g., .txt, you can use: ls -a *.txt
+namespace {
 
-using namespace std;
+// trace events kept by --trace (40 bytes each); the passes after that only count in the profile
+constexpr std::size_t traceCapacity = std::size_t(1) << 20;
 
-void showVectorVals(const std::string &label, std::vector<double> &v) {
-    std::cout << label << " ";
-    for (std::size_t i = 0; i < v.size(); ++i) {
-        std::cout << v[i] << " ";
+struct CliOptions {
+    std::string dataFile = "data/xor.txt";
+    std::vector<unsigned> topology;     // empty: the data file's
+    Activation hiddenActivation = Activation::Tanh;
+    Activation outputActivation = Activation::Tanh;
+    bool floatNet = false;
+    std::string loadModel;
+    std::string saveModel;
+    std::optional<OptimizerType> optimizer; // default: momentum, or the loaded model's
+    std::optional<double> learningRate; // default: the optimizer's
+    std::optional<double> momentum;
+    ScheduleType schedule = ScheduleType::Constant;
+    std::size_t warmupEpochs = 0;
+    double validationFraction = 0.0;
+    std::size_t logEvery = 1;
+    std::string profileFile;
+    std::string traceFile;
+    TrainingOptions training;
+};
+
+void printUsage(const char *program) {
+    std::cout
+        << "Usage: " << program << " [options]\n"
+        << "\n"
+        << "Data and model:\n"
+        << "  --data FILE              training data, text or binary (default data/xor.txt)\n"
+        << "  --topology N,N,...       layer sizes (default: the data file's topology line)\n"
+        << "  --activation NAME        hidden layers: tanh, sigmoid, relu, linear (default tanh)\n"
+        << "  --output-activation NAME output layer (default tanh)\n"
+        << "  --float                  train in float32 instead of float64\n"
+        << "  --load-model FILE        continue training a saved model\n"
+        << "  --save-model FILE        save the trained model\n"
+        << "\n"
+        << "Training:\n"
+        << "  --epochs N               passes over the data (default 1)\n"
+        << "  --batch N                samples per weight update (default 1)\n"
+        << "  --threads N              training threads, 0 = one per hardware thread (default 1)\n"
+        << "  --hogwild                asynchronous lock-free updates instead of split batches\n"
+        << "  --no-shuffle             keep file order instead of shuffling every epoch\n"
+        << "  --seed N                 seed of the shuffle and the validation split (default 1)\n"
+        << "  --optimizer NAME         momentum, nesterov, adam, rmsprop (default momentum, or the loaded model's)\n"
+        << "  --lr X                   learning rate (default 0.15, 0.001 for adam and rmsprop)\n"
+        << "  --momentum X             momentum, or beta1 for adam\n"
+        << "  --schedule NAME          constant, step (a tenth after each third), cosine (default constant)\n"
+        << "  --warmup N               epochs of linear learning-rate warmup (default 0)\n"
+        << "  --validation F           hold out fraction F of the samples to measure the error (default 0)\n"
+        << "  --patience N             stop after N epochs without a lower validation error, needs --validation (default 0 = never)\n"
+        << "\n"
+        << "Output:\n"
+        << "  --log-every N            progress line every N epochs, 0 = summary only (default 1)\n"
+        << "  --profile FILE           print per-layer timings and write them as JSON (needs NN_ENABLE_PROFILING)\n"
+        << "  --trace FILE             write the layer passes in Chrome trace event format (needs NN_ENABLE_PROFILING)\n"
+        << "  --help                   show this text\n";
+}
+
+template<typename Number>
+Number parseNumber(const std::string &option, const std::string &text) {
+    Number value{};
+    const char *end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end) {
+        throw std::invalid_argument("Invalid value for " + option + ": " + text);
     }
+    return value;
 }
 
-int main() {
-    TrainingData trainingData("data/xor.txt");
-    std::cout << "Finished reading training data" << std::endl;
-    // e.g., { 3, 2, 1 } means 3 neurons in the input layer, 2 in the hidden layer, and 1 in the output layer
+std::vector<unsigned> parseTopology(const std::string &text) {
     std::vector<unsigned> topology;
-    trainingData.getTopology(topology);
-    std::cout << topology[1] << std::endl;
-    std::cout << "Finished reading topology" << std::endl;
-    Net myNet(topology);
-    std::cout << "Finished creating the NET" << std::endl;
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        const std::size_t comma = std::min(text.find(',', start), text.size());
+        const auto count = parseNumber<unsigned>("--topology", text.substr(start, comma - start));
+        if (count == 0) {
+            throw std::invalid_argument("Every layer of --topology needs at least one neuron");
+        }
+        topology.push_back(count);
+        start = comma + 1;
+    }
+    if (topology.size() < 2) {
+        throw std::invalid_argument("--topology needs at least an input and an output layer");
+    }
+    return topology;
+}
 
-    std::vector<double> inputVals, targetVals, resultVals;
-    int trainingPass = 0;
+Activation parseActivationOption(const std::string &option, const std::string &name) {
+    Activation activation;
+    if (!parseActivation(name, activation)) {
+        throw std::invalid_argument("Unknown activation for " + option + ": " + name);
+    }
+    return activation;
+}
 
-    while (!trainingData.isEof()) {
-        ++trainingPass;
-        std::cout << std::endl << "Pass: " << trainingPass;
+// returns std::nullopt if --help was given
+std::optional<CliOptions> parseArguments(const int argc, char *argv[]) {
+    CliOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        // the value of an option that takes one
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + option);
+            }
+            return argv[++i];
+        };
 
-        // Get new input data and feed it forward;
-        if (trainingData.getNextInputs(inputVals) != static_cast<std::size_t>(topology[0])) {
-            break;
+        if (option == "--help" || option == "-h") {
+            return std::nullopt;
+        } else if (option == "--data") {
+            options.dataFile = value();
+        } else if (option == "--topology") {
+            options.topology = parseTopology(value());
+        } else if (option == "--activation") {
+            options.hiddenActivation = parseActivationOption(option, value());
+        } else if (option == "--output-activation") {
+            options.outputActivation = parseActivationOption(option, value());
+        } else if (option == "--float") {
+            options.floatNet = true;
+        } else if (option == "--load-model") {
+            options.loadModel = value();
+        } else if (option == "--save-model") {
+            options.saveModel = value();
+        } else if (option == "--epochs") {
+            options.training.epochs = parseNumber<std::size_t>(option, value());
+        } else if (option == "--batch") {
+            options.training.batchSize = parseNumber<std::size_t>(option, value());
+            if (options.training.batchSize == 0) {
+                throw std::invalid_argument("--batch needs at least 1 sample");
+            }
+        } else if (option == "--threads") {
+            options.training.threadCount = parseNumber<unsigned>(option, value());
+        } else if (option == "--hogwild") {
+            options.training.hogwild = true;
+        } else if (option == "--no-shuffle") {
+            options.training.shuffle = false;
+        } else if (option == "--seed") {
+            options.training.seed = parseNumber<std::uint64_t>(option, value());
+        } else if (option == "--optimizer") {
+            const std::string name = value();
+            OptimizerType type;
+            if (!parseOptimizer(name, type)) {
+                throw std::invalid_argument("Unknown optimizer: " + name);
+            }
+            options.optimizer = type;
+        } else if (option == "--lr") {
+            options.learningRate = parseNumber<double>(option, value());
+        } else if (option == "--momentum") {
+            options.momentum = parseNumber<double>(option, value());
+        } else if (option == "--schedule") {
+            const std::string name = value();
+            if (!parseSchedule(name, options.schedule)) {
+                throw std::invalid_argument("Unknown schedule: " + name);
+            }
+        } else if (option == "--warmup") {
+            options.warmupEpochs = parseNumber<std::size_t>(option, value());
+        } else if (option == "--validation") {
+            options.validationFraction = parseNumber<double>(option, value());
+            if (options.validationFraction < 0.0 || options.validationFraction >= 1.0) {
+                throw std::invalid_argument("--validation must be in [0, 1)");
+            }
+        } else if (option == "--patience") {
+            options.training.patience = parseNumber<std::size_t>(option, value());
+        } else if (option == "--log-every") {
+            options.logEvery = parseNumber<std::size_t>(option, value());
+        } else if (option == "--profile") {
+            options.profileFile = value();
+        } else if (option == "--trace") {
+            options.traceFile = value();
+        } else {
+            throw std::invalid_argument("Unknown option: " + option + " (see --help)");
         }
-        showVectorVals("; Inputs:", inputVals);
-        myNet.feedForward(inputVals);
+    }
+    // early stopping watches the validation error, without validation samples it would never stop
+    if (options.training.patience > 0 && options.validationFraction == 0.0) {
+        throw std::invalid_argument("--patience needs --validation");
+    }
 
-        myNet.getResults(resultVals);
-        showVectorVals("Outputs:", resultVals);
+    const std::size_t epochs = options.training.epochs;
+    const std::size_t warmup = options.warmupEpochs;
+    switch (options.schedule) {
+        case ScheduleType::Step: {
+            const std::size_t scheduled = epochs > warmup ? epochs - warmup : 1;
+            options.training.schedule = LearningRateSchedule::step(std::max<std::size_t>(1, (scheduled + 2) / 3), 0.1, warmup);
+            break;
+        }
+        case ScheduleType::Cosine:
+            options.training.schedule = LearningRateSchedule::cosine(0.0, warmup);
+            break;
+        case ScheduleType::Constant:
+            options.training.schedule = LearningRateSchedule::constant(warmup);
+            break;
+    }
+    return options;
+}
 
-        trainingData.getTargetOutputs(targetVals);
-        showVectorVals("Targets: ", targetVals);
-        assert(targetVals.size() == topology.back());
+// the optimizer given with --optimizer, or else current, with --lr and --momentum applied
+Optimizer makeOptimizer(const CliOptions &options, const Optimizer &current) {
+    Optimizer optimizer = current;
+    if (options.optimizer) {
+        switch (*options.optimizer) {
+            case OptimizerType::Momentum: optimizer = Optimizer::sgd(); break;
+            case OptimizerType::Nesterov: optimizer = Optimizer::nesterov(); break;
+            case OptimizerType::Adam: optimizer = Optimizer::adam(); break;
+            case OptimizerType::RMSProp: optimizer = Optimizer::rmsProp(); break;
+        }
+    }
+    if (options.learningRate) optimizer.learningRate = *options.learningRate;
+    if (options.momentum) optimizer.momentum = *options.momentum;
+    return optimizer;
+}
 
-        myNet.backPropagate(targetVals);
+// The samples to train and validate on. Without validation a binary file is trained on straight
+// from its memory mapping; otherwise the samples are loaded and split.
+struct TrainingSamples {
+    std::unique_ptr<SampleSource> training;
+    std::unique_ptr<Dataset> validation;
+    std::vector<unsigned> topology;
+};
 
-        std::cout << "Net recent average error: " << myNet.getRecentAverageError() << std::endl;
+TrainingSamples loadSamples(const CliOptions &options) {
+    TrainingSamples samples;
+    if (options.validationFraction == 0.0 && BinaryDataset::isBinaryDataset(options.dataFile)) {
+        auto binary = std::make_unique<BinaryDataset>(options.dataFile);
+        samples.topology = binary->getTopology();
+        samples.training = std::move(binary);
+        return samples;
+    }
+    Dataset dataset = Dataset::load(options.dataFile);
+    samples.topology = dataset.getTopology();
+    if (options.validationFraction > 0.0) {
+        auto [training, validation] = dataset.split(options.validationFraction, options.training.seed);
+        samples.training = std::make_unique<Dataset>(std::move(training));
+        samples.validation = std::make_unique<Dataset>(std::move(validation));
+    } else {
+        samples.training = std::make_unique<Dataset>(std::move(dataset));
     }
+    return samples;
+}
 
-    std::cout << std::endl << "Training done! Starting testing:" << std::endl;
+template<typename T>
+BasicNet<T> makeNet(const CliOptions &options, const std::vector<unsigned> &dataTopology) {
+    if (!options.loadModel.empty()) {
+        return BasicNet<T>::load(options.loadModel);
+    }
+    const std::vector<unsigned> topology = options.topology.empty() ? dataTopology : options.topology;
+    std::vector<Activation> activations(topology.size() - 1, options.hiddenActivation);
+    activations.back() = options.outputActivation;
+    return BasicNet<T>(topology, activations);
+}
 
-    cout << endl << "0 and 1:" << endl;
-    std::vector<double> testVals = {0, 1};
-    myNet.feedForward(testVals);
-    myNet.getResults(testVals);
+// time of every layer's passes and their share of the total
+void printProfile(const Profiler &profiler) {
+    const std::vector<LayerProfile> layers = profiler.getLayers();
+    std::uint64_t total = 0;
+    for (const LayerProfile &layer : layers) {
+        for (const PhaseStats &stats : layer.phases) {
+            total += stats.nanoseconds;
+        }
+    }
+    std::cout << "Profile (ms, share, GFLOP/s):\n" << std::fixed;
+    for (std::size_t l = 0; l < layers.size(); ++l) {
+        std::cout << "  layer " << l << " " << layers[l].inputs << "->" << layers[l].outputs;
+        for (const ProfilePhase phase : {ProfilePhase::Forward, ProfilePhase::Backward, ProfilePhase::Update}) {
+            const PhaseStats &stats = layers[l][phase];
+            const double share = total == 0 ? 0.0 : 100.0 * static_cast<double>(stats.nanoseconds) / static_cast<double>(total);
+            std::cout << "  " << profilePhaseName(phase) << " " << std::setprecision(1)
+                      << static_cast<double>(stats.nanoseconds) / 1e6 << " (" << std::setprecision(0) << share << "%, "
+                      << std::setprecision(2) << stats.gflops() << ")";
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
 
-    cout << endl << "1 and 0:" << endl;
-    testVals = {1, 0};
-    myNet.feedForward(testVals);
-    myNet.getResults(testVals);
+template<typename T>
+int run(const CliOptions &options) {
+    const TrainingSamples samples = loadSamples(options);
+    BasicNet<T> net = makeNet<T>(options, samples.topology);
+    if (net.getInputCount() != samples.training->getInputCount() ||
+        net.getOutputCount() != samples.training->getTargetCount()) {
+        std::cerr << "Error: the net has " << net.getInputCount() << " inputs and " << net.getOutputCount()
+                  << " outputs, but the samples in " << options.dataFile << " have "
+                  << samples.training->getInputCount() << " and " << samples.training->getTargetCount() << std::endl;
+        return 1;
+    }
+    // a new net starts with momentum SGD, a loaded model keeps its optimizer unless one is asked for
+    net.setOptimizer(makeOptimizer(options, net.getOptimizer()));
 
-    cout << endl << "1 and 1:" << endl;
-    testVals = {1, 1};
-    myNet.feedForward(testVals);
-    myNet.getResults(testVals);
+    std::cout << "Training on " << samples.training->getSampleCount() << " samples";
+    if (samples.validation) {
+        std::cout << ", validating on " << samples.validation->getSampleCount();
+    }
+    std::cout << " (" << (options.floatNet ? "float32" : "float64") << ", "
+              << optimizerName(net.getOptimizer().type) << ")\n";
 
-    cout << endl << "0 and 0:" << endl;
-    testVals = {0, 0};
-    myNet.feedForward(testVals);
-    myNet.getResults(testVals);
+    const bool profile = !options.profileFile.empty() || !options.traceFile.empty();
+    if (profile && !profilingEnabled) {
+        std::cerr << "Warning: built without NN_ENABLE_PROFILING, the profile will be empty" << std::endl;
+    }
+    net.getProfiler().reset();
+    if (!options.traceFile.empty()) {
+        net.getProfiler().setTraceCapacity(traceCapacity);
+    }
 
-    showVectorVals("Test results: ", testVals);
-    cout << myNet.getRecentAverageError() << endl;
+    Trainer trainer(options.training);
+    if (options.logEvery > 0) {
+        trainer.setEpochCallback([&options, validate = samples.validation != nullptr](const TrainingProgress &progress) {
+            if (progress.epoch % options.logEvery != 0 && progress.epoch != progress.epochCount) {
+                return;
+            }
+            std::cout << "epoch " << progress.epoch << "/" << progress.epochCount
+                      << "  error " << std::setprecision(6) << progress.error;
+            if (validate) {
+                std::cout << "  validation " << progress.validationError;
+            }
+            std::cout << "  lr " << progress.learningRate
+                      << "  " << std::fixed << std::setprecision(1) << progress.epochSeconds * 1e3 << " ms"
+                      << "  " << std::setprecision(0) << progress.samplesPerSecond() << " samples/s\n"
+                      << std::defaultfloat;
+        });
+    }
+    const TrainingResult result = trainer.train(net, *samples.training, samples.validation.get());
 
-    testVals = {1, 0};
-    myNet.printPrediction(testVals);
+    const TrainingProgress &progress = result.progress;
+    const double epochMs = progress.epoch > 0 ? progress.seconds * 1e3 / static_cast<double>(progress.epoch) : 0.0;
+    std::cout << "Trained " << progress.epoch << " epochs, " << progress.samples << " samples in " << std::fixed
+              << std::setprecision(3) << progress.seconds << " s (" << std::setprecision(0)
+              << progress.samplesPerSecond() << " samples/s, " << std::setprecision(2) << epochMs << " ms/epoch)\n"
+              << std::defaultfloat << std::setprecision(6) << "Final error: " << progress.error << "\n";
+    if (result.stoppedEarly) {
+        std::cout << "Stopped early: no improvement for " << options.training.patience << " epochs\n";
+    }
+    if (result.restoredBest) {
+        std::cout << "Best validation error: " << result.bestValidationError << " (epoch " << result.bestEpoch
+                  << ", weights restored)\n";
+    }
+    if (profile) {
+        printProfile(net.getProfiler());
+    }
+    if (!options.profileFile.empty()) {
+        net.getProfiler().saveJson(options.profileFile);
+        std::cout << "Saved profile to " << options.profileFile << "\n";
+    }
+    if (!options.traceFile.empty()) {
+        net.getProfiler().saveChromeTrace(options.traceFile);
+        std::cout << "Saved " << net.getProfiler().getTraceEventCount() << " trace events to " << options.traceFile << "\n";
+    }
+    if (!options.saveModel.empty()) {
+        net.save(options.saveModel);
+        std::cout << "Saved model to " << options.saveModel << "\n";
+    }
+    std::cout << std::flush;
     return 0;
 }
+
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        const std::optional<CliOptions> options = parseArguments(argc, argv);
+        if (!options) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        return options->floatNet ? run<float>(*options) : run<double>(*options);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
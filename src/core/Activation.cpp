@@ -0,0 +1,25 @@
+//
+// Transfer functions a layer can use.
+//
+
+#include "Activation.h"
+
+const char *activationName(const Activation activation) {
+    switch (activation) {
+        case Activation::Tanh: return "tanh";
+        case Activation::Sigmoid: return "sigmoid";
+        case Activation::ReLU: return "relu";
+        case Activation::Linear: return "linear";
+    }
+    return "tanh";
+}
+
+bool parseActivation(const std::string &name, Activation &activation) {
+    for (const Activation candidate : {Activation::Tanh, Activation::Sigmoid, Activation::ReLU, Activation::Linear}) {
+        if (name == activationName(candidate)) {
+            activation = candidate;
+            return true;
+        }
+    }
+    return false;
+}
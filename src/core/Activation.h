@@ -0,0 +1,70 @@
+//
+// Transfer functions a layer can use.
+//
+
+#ifndef XORGATE_NEURALNETWORK_ACTIVATION_H
+#define XORGATE_NEURALNETWORK_ACTIVATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+enum class Activation {
+    Tanh,    // output range [-1.0..1.0], smooth curve
+    Sigmoid, // output range [0.0..1.0], smooth curve
+    ReLU,    // max(0, x), cheap and does not saturate for positive inputs
+    Linear   // identity, e.g. for regression outputs
+};
+
+// lower-case name ("tanh", "sigmoid", "relu", "linear"), used in files and on the command line
+const char *activationName(Activation activation);
+
+// parses a name produced by activationName; returns false for unknown names
+bool parseActivation(const std::string &name, Activation &activation);
+
+// tanh as a clamped rational function x * P(x^2) / Q(x^2), |error| < 4e-7 on the whole real line.
+// The kernels and StaticNet share these coefficients, so all of them compute the same curve.
+namespace tanhApproximation {
+inline constexpr double limit = 7.90531110763549805; // tanh(limit) rounds to 1 in float
+// coefficients of P and Q, highest power first
+inline constexpr double p[] = {-2.76076847742355e-16, 2.00018790482477e-13, -8.60467152213735e-11,
+                               5.12229709037114e-08, 1.48572235717979e-05, 6.37261928875436e-04,
+                               4.89352455891786e-03};
+inline constexpr double q[] = {1.19825839466702e-06, 1.18534705686654e-04, 2.26843463243900e-03,
+                               4.89352518554385e-03};
+}
+
+// f(x) for a single value, with the same tanh approximation as kernels::biasActivate
+template<typename T>
+constexpr T activate(const Activation activation, T x) {
+    switch (activation) {
+        case Activation::Tanh:
+        case Activation::Sigmoid: {
+            // sigmoid(x) = 0.5 + 0.5 * tanh(x / 2)
+            const bool sigmoid = activation == Activation::Sigmoid;
+            if (sigmoid) {
+                x *= T(0.5);
+            }
+            x = std::clamp(x, T(-tanhApproximation::limit), T(tanhApproximation::limit));
+            const T x2 = x * x;
+            T p = T(tanhApproximation::p[0]);
+            for (std::size_t k = 1; k < std::size(tanhApproximation::p); ++k) {
+                p = x2 * p + T(tanhApproximation::p[k]);
+            }
+            T q = T(tanhApproximation::q[0]);
+            for (std::size_t k = 1; k < std::size(tanhApproximation::q); ++k) {
+                q = x2 * q + T(tanhApproximation::q[k]);
+            }
+            const T y = x * p / q;
+            return sigmoid ? T(0.5) * y + T(0.5) : y;
+        }
+        case Activation::ReLU:
+            return std::max(x, T(0));
+        case Activation::Linear:
+            break;
+    }
+    return x;
+}
+
+#endif //XORGATE_NEURALNETWORK_ACTIVATION_H
@@ -0,0 +1,42 @@
+//
+// One aligned block of memory from which a net places all its arrays.
+//
+
+#include "Arena.h"
+#include <cstring>
+#include <new>
+#include <utility>
+
+Arena::Arena(const std::size_t capacity)
+    : m_data(capacity == 0 ? nullptr : static_cast<std::byte *>(::operator new(capacity, std::align_val_t{alignment})))
+    , m_capacity(capacity)
+{
+    if (m_data) {
+        std::memset(m_data, 0, capacity);
+    }
+}
+
+Arena::~Arena() {
+    if (m_data) {
+        ::operator delete(m_data, std::align_val_t{alignment});
+    }
+}
+
+Arena::Arena(Arena &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_capacity(std::exchange(other.m_capacity, 0))
+    , m_used(std::exchange(other.m_used, 0))
+{
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+    if (this != &other) {
+        if (m_data) {
+            ::operator delete(m_data, std::align_val_t{alignment});
+        }
+        m_data = std::exchange(other.m_data, nullptr);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        m_used = std::exchange(other.m_used, 0);
+    }
+    return *this;
+}
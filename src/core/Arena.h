@@ -0,0 +1,64 @@
+//
+// One aligned block of memory from which a net places all its arrays.
+//
+
+#ifndef XORGATE_NEURALNETWORK_ARENA_H
+#define XORGATE_NEURALNETWORK_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+// An Arena is allocated once with the total size its owner computed up front, then hands out
+// arrays by bumping an offset. Every array starts on a cache line (which also suits every SIMD
+// load), and the memory starts out zeroed. Nothing is freed individually: reset() starts over
+// from the beginning and the destructor releases the whole block.
+//
+// The owner decides the layout, so it can place the same arrays again in the same order, e.g.
+// after copying or growing the arena. Moving an arena keeps the block, so spans into it stay valid.
+class Arena {
+public:
+    static constexpr std::size_t alignment = 64;
+
+    Arena() = default;
+    // allocates capacity bytes, zeroed
+    explicit Arena(std::size_t capacity);
+    ~Arena();
+
+    Arena(Arena &&other) noexcept;
+    Arena &operator=(Arena &&other) noexcept;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // bytes an array of count Ts takes up, padding to the next array included
+    template<typename T>
+    static constexpr std::size_t bytesFor(const std::size_t count) {
+        return (count * sizeof(T) + alignment - 1) / alignment * alignment;
+    }
+
+    // the next count Ts; the arena must have room for them (see bytesFor)
+    template<typename T>
+    std::span<T> allocate(const std::size_t count) {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= alignment);
+        const std::size_t bytes = bytesFor<T>(count);
+        assert(bytes <= m_capacity - m_used);
+        T *array = reinterpret_cast<T *>(m_data + m_used);
+        m_used += bytes;
+        return {array, count};
+    }
+
+    // hands out the memory again from the start; previously handed out arrays keep their values
+    void reset() { m_used = 0; }
+
+    [[nodiscard]] std::size_t capacity() const { return m_capacity; }
+    [[nodiscard]] std::size_t used() const { return m_used; }
+
+private:
+    std::byte *m_data = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_used = 0;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_ARENA_H
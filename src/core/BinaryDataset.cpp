@@ -0,0 +1,190 @@
+//
+// Compact binary training data, read through a memory mapping without parsing or copying.
+//
+
+#include "BinaryDataset.h"
+#include "CheckedSize.h"
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr char Magic[8] = {'N', 'N', 'D', 'A', 'T', 'A', '\0', '\0'};
+constexpr std::uint32_t FormatVersion = 1;
+constexpr std::size_t HeaderSize = 56;
+constexpr std::size_t BlockAlignment = 64;
+
+// The blocks are handed out as native arrays, so the host has to share the file's byte order.
+static_assert(std::endian::native == std::endian::little,
+              "the binary dataset format is little-endian; big-endian hosts are not supported");
+
+template<typename T>
+T readField(const unsigned char *data, const std::size_t offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+std::size_t alignUp(const std::size_t offset) {
+    return (offset + BlockAlignment - 1) / BlockAlignment * BlockAlignment;
+}
+
+template<typename T>
+void writeField(std::ofstream &out, const T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void writePadding(std::ofstream &out, const std::size_t from, const std::size_t to) {
+    static constexpr char Zeros[BlockAlignment] = {};
+    out.write(Zeros, static_cast<std::streamsize>(to - from));
+}
+
+template<typename T>
+void writeDataset(const std::string &filename, const std::vector<unsigned> &topology, const std::size_t sampleCount,
+                  const T *inputs, const T *targets) {
+    if (topology.size() < 2) {
+        throw std::invalid_argument("Topology needs at least an input and an output layer");
+    }
+    const std::size_t inputCount = topology.front();
+    const std::size_t targetCount = topology.back();
+    const std::size_t inputBytes = sampleCount * inputCount * sizeof(T);
+    const std::size_t targetBytes = sampleCount * targetCount * sizeof(T);
+    const std::size_t topologyEnd = HeaderSize + topology.size() * sizeof(std::uint32_t);
+    const std::size_t inputsOffset = alignUp(topologyEnd);
+    const std::size_t targetsOffset = alignUp(inputsOffset + inputBytes);
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot create file: " + filename);
+    }
+    out.write(Magic, sizeof(Magic));
+    writeField<std::uint32_t>(out, FormatVersion);
+    writeField<std::uint32_t>(out, std::is_same_v<T, float> ? 1u : 2u);
+    writeField<std::uint64_t>(out, sampleCount);
+    writeField<std::uint32_t>(out, static_cast<std::uint32_t>(inputCount));
+    writeField<std::uint32_t>(out, static_cast<std::uint32_t>(targetCount));
+    writeField<std::uint64_t>(out, inputsOffset);
+    writeField<std::uint64_t>(out, targetsOffset);
+    writeField<std::uint32_t>(out, static_cast<std::uint32_t>(topology.size()));
+    writeField<std::uint32_t>(out, 0);
+    for (const unsigned n : topology) {
+        writeField<std::uint32_t>(out, n);
+    }
+    writePadding(out, topologyEnd, inputsOffset);
+    out.write(reinterpret_cast<const char *>(inputs), static_cast<std::streamsize>(inputBytes));
+    writePadding(out, inputsOffset + inputBytes, targetsOffset);
+    out.write(reinterpret_cast<const char *>(targets), static_cast<std::streamsize>(targetBytes));
+    if (!out) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+}
+
+BinaryDataset::BinaryDataset(const std::string &filename)
+    : m_file(std::make_unique<MappedFile>(filename))
+{
+    const unsigned char *data = m_file->data();
+    const std::size_t size = m_file->size();
+    if (size < HeaderSize || std::memcmp(data, Magic, sizeof(Magic)) != 0) {
+        throw std::runtime_error("Not a binary training data file: " + filename);
+    }
+    if (readField<std::uint32_t>(data, 8) != FormatVersion) {
+        throw std::runtime_error("Unsupported binary training data version: " + filename);
+    }
+
+    const auto dataType = readField<std::uint32_t>(data, 12);
+    if (dataType != 1 && dataType != 2) {
+        throw std::runtime_error("Unknown data type in binary training data: " + filename);
+    }
+    m_dataType = static_cast<DataType>(dataType);
+    m_sampleCount = static_cast<std::size_t>(readField<std::uint64_t>(data, 16));
+    m_inputCount = readField<std::uint32_t>(data, 24);
+    m_targetCount = readField<std::uint32_t>(data, 28);
+    m_inputsOffset = static_cast<std::size_t>(readField<std::uint64_t>(data, 32));
+    m_targetsOffset = static_cast<std::size_t>(readField<std::uint64_t>(data, 40));
+    const std::size_t layerCount = readField<std::uint32_t>(data, 48);
+
+    if (layerCount < 2 || HeaderSize + layerCount * sizeof(std::uint32_t) > size) {
+        throw std::runtime_error("Corrupt topology in binary training data: " + filename);
+    }
+    for (std::size_t l = 0; l < layerCount; ++l) {
+        m_topology.push_back(readField<std::uint32_t>(data, HeaderSize + l * sizeof(std::uint32_t)));
+    }
+
+    const std::size_t valueSize = m_dataType == DataType::Float32 ? sizeof(float) : sizeof(double);
+    const bool aligned = m_inputsOffset % valueSize == 0 && m_targetsOffset % valueSize == 0;
+    // both arrays must lie inside the file; the counts are untrusted, so no product may wrap
+    const auto fits = [&](const std::size_t offset, const std::size_t rowLength) {
+        std::size_t values = 0;
+        std::size_t bytes = 0;
+        return offset <= size && addProduct(values, m_sampleCount, rowLength) &&
+               addProduct(bytes, values, valueSize) && bytes <= size - offset;
+    };
+    if (m_inputCount != m_topology.front() || m_targetCount != m_topology.back() || !aligned ||
+        !fits(m_inputsOffset, m_inputCount) || !fits(m_targetsOffset, m_targetCount)) {
+        throw std::runtime_error("Corrupt binary training data: " + filename);
+    }
+}
+
+bool BinaryDataset::isBinaryDataset(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(Magic)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+void BinaryDataset::write(const std::string &filename, const std::vector<unsigned> &topology,
+                          const std::size_t sampleCount, const float *inputs, const float *targets) {
+    writeDataset(filename, topology, sampleCount, inputs, targets);
+}
+
+void BinaryDataset::write(const std::string &filename, const std::vector<unsigned> &topology,
+                          const std::size_t sampleCount, const double *inputs, const double *targets) {
+    writeDataset(filename, topology, sampleCount, inputs, targets);
+}
+
+void BinaryDataset::getInputs(const std::size_t sample, std::vector<double> &inputVals) const {
+    copyRow(m_inputsOffset, sample, m_inputCount, inputVals);
+}
+
+void BinaryDataset::getTargets(const std::size_t sample, std::vector<double> &targetVals) const {
+    copyRow(m_targetsOffset, sample, m_targetCount, targetVals);
+}
+
+void BinaryDataset::gatherBatch(const std::size_t *indices, const std::size_t count, float *inputs,
+                                float *targets) const {
+    gatherRows(m_inputsOffset, indices, count, m_inputCount, inputs);
+    gatherRows(m_targetsOffset, indices, count, m_targetCount, targets);
+}
+
+void BinaryDataset::gatherRows(const std::size_t offset, const std::size_t *rows, const std::size_t count,
+                               const std::size_t width, float *values) const {
+    for (std::size_t r = 0; r < count; ++r) {
+        assert(rows[r] < m_sampleCount);
+        float *dst = values + r * width;
+        if (m_dataType == DataType::Float32) {
+            std::memcpy(dst, block<float>(offset) + rows[r] * width, width * sizeof(float));
+        } else {
+            const double *src = block<double>(offset) + rows[r] * width;
+            for (std::size_t i = 0; i < width; ++i) {
+                dst[i] = static_cast<float>(src[i]);
+            }
+        }
+    }
+}
+
+void BinaryDataset::copyRow(const std::size_t offset, const std::size_t row, const std::size_t width,
+                            std::vector<double> &values) const {
+    values.resize(width);
+    if (m_dataType == DataType::Float32) {
+        const float *src = block<float>(offset) + row * width;
+        for (std::size_t i = 0; i < width; ++i) {
+            values[i] = static_cast<double>(src[i]);
+        }
+    } else {
+        const double *src = block<double>(offset) + row * width;
+        values.assign(src, src + width);
+    }
+}
@@ -0,0 +1,98 @@
+//
+// Compact binary training data, read through a memory mapping without parsing or copying.
+//
+
+#ifndef XORGATE_NEURALNETWORK_BINARYDATASET_H
+#define XORGATE_NEURALNETWORK_BINARYDATASET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "MappedFile.h"
+#include "SampleSource.h"
+
+// File layout (all little-endian):
+//   offset  0  char[8]   magic "NNDATA\0\0"
+//           8  uint32    format version (1)
+//          12  uint32    data type: 1 = float32, 2 = float64
+//          16  uint64    sample count
+//          24  uint32    input count per sample
+//          28  uint32    target count per sample
+//          32  uint64    byte offset of the input block
+//          40  uint64    byte offset of the target block
+//          48  uint32    number of layers in the topology
+//          52  uint32    reserved (0)
+//          56  uint32[]  topology
+// The input block holds sampleCount x inputCount values, row-major; the target block holds
+// sampleCount x targetCount values. Both start at 64-byte aligned offsets.
+//
+// As a SampleSource it trains straight from the mapping, so files larger than memory work and
+// nothing is copied up front; float64 files are converted batch by batch.
+class BinaryDataset : public SampleSource {
+public:
+    enum class DataType : std::uint32_t { Float32 = 1, Float64 = 2 };
+
+    // maps and validates the file, including that both arrays (sample count times row length
+    // values) lie inside it without overflowing; throws std::runtime_error on a missing or
+    // malformed file
+    explicit BinaryDataset(const std::string &filename);
+
+    // true if the file starts with the binary dataset magic
+    static bool isBinaryDataset(const std::string &filename);
+
+    // writes sampleCount samples; inputs and targets are row-major with topology.front() and
+    // topology.back() values per sample
+    static void write(const std::string &filename, const std::vector<unsigned> &topology,
+                      std::size_t sampleCount, const float *inputs, const float *targets);
+    static void write(const std::string &filename, const std::vector<unsigned> &topology,
+                      std::size_t sampleCount, const double *inputs, const double *targets);
+
+    [[nodiscard]] const std::vector<unsigned> &getTopology() const { return m_topology; }
+    [[nodiscard]] std::size_t getSampleCount() const override { return m_sampleCount; }
+    [[nodiscard]] std::size_t getInputCount() const override { return m_inputCount; }
+    [[nodiscard]] std::size_t getTargetCount() const override { return m_targetCount; }
+    [[nodiscard]] DataType getDataType() const { return m_dataType; }
+
+    // Zero-copy access to the input and target blocks. T has to match the stored data type.
+    template<typename T>
+    [[nodiscard]] const T *getInputs() const { return block<T>(m_inputsOffset); }
+    template<typename T>
+    [[nodiscard]] const T *getTargets() const { return block<T>(m_targetsOffset); }
+
+    // one sample, converted to double whatever the stored type
+    void getInputs(std::size_t sample, std::vector<double> &inputVals) const;
+    void getTargets(std::size_t sample, std::vector<double> &targetVals) const;
+
+    void gatherBatch(const std::size_t *indices, std::size_t count, float *inputs, float *targets) const override;
+
+private:
+    template<typename T>
+    const T *block(const std::size_t offset) const {
+        static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>);
+        const DataType requested = std::is_same_v<T, float> ? DataType::Float32 : DataType::Float64;
+        if (requested != m_dataType) {
+            throw std::logic_error("Binary dataset holds a different data type");
+        }
+        return reinterpret_cast<const T *>(m_file->data() + offset);
+    }
+
+    void copyRow(std::size_t offset, std::size_t row, std::size_t width, std::vector<double> &values) const;
+    void gatherRows(std::size_t offset, const std::size_t *rows, std::size_t count, std::size_t width,
+                    float *values) const;
+
+    std::unique_ptr<MappedFile> m_file;
+    std::vector<unsigned> m_topology;
+    std::size_t m_sampleCount = 0;
+    std::size_t m_inputCount = 0;
+    std::size_t m_targetCount = 0;
+    std::size_t m_inputsOffset = 0;
+    std::size_t m_targetsOffset = 0;
+    DataType m_dataType = DataType::Float32;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_BINARYDATASET_H
@@ -0,0 +1,21 @@
+//
+// Size arithmetic on counts read from files, which must not wrap around.
+//
+
+#ifndef XORGATE_NEURALNETWORK_CHECKEDSIZE_H
+#define XORGATE_NEURALNETWORK_CHECKEDSIZE_H
+
+#include <cstddef>
+#include <limits>
+
+// total += a * b; false, leaving total unchanged, if that overflows
+inline bool addProduct(std::size_t &total, const std::size_t a, const std::size_t b) {
+    const std::size_t max = std::numeric_limits<std::size_t>::max();
+    if (a != 0 && b > max / a) return false;
+    if (a * b > max - total) return false;
+    total += a * b;
+    return true;
+}
+
+
+#endif //XORGATE_NEURALNETWORK_CHECKEDSIZE_H
@@ -11,6 +11,12 @@ Connection::Connection()  {
     deltaWeight = 0; // deltaWeight is the change in weight of the connection
 }
 
+Connection::Connection(const double weight, const double deltaWeight)
+    : weight(weight)
+    , deltaWeight(deltaWeight)
+{
+}
+
 double Connection::randomWeight() {
     // Small centered weights to avoid tanh saturation (was [0,1] -> all outputs went to 1)
     return (rand() / static_cast<double>(RAND_MAX) - 0.5) * 2.0 / std::sqrt(2.0);  // ~[-0.7, 0.7]
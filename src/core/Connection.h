@@ -9,6 +9,7 @@
 class Connection {
 public:
     Connection();
+    Connection(double weight, double deltaWeight);
     double weight; // weight is the weight of the connection
     double deltaWeight{}; // deltaWeight is the change in weight of the connection
     static double randomWeight();
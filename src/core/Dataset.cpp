@@ -0,0 +1,88 @@
+//
+// Training samples held in memory as contiguous float arrays.
+//
+
+#include "Dataset.h"
+#include "BinaryDataset.h"
+#include "MappedFile.h"
+#include "TextParser.h"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+Dataset::Dataset(std::vector<unsigned> topology, std::vector<float> inputs, std::vector<float> targets)
+    : m_topology(std::move(topology))
+    , m_inputCount(m_topology.empty() ? 0 : m_topology.front())
+    , m_targetCount(m_topology.empty() ? 0 : m_topology.back())
+    , m_sampleCount(m_inputCount == 0 ? 0 : inputs.size() / m_inputCount)
+    , m_inputs(std::move(inputs))
+    , m_targets(std::move(targets))
+{
+    if (m_topology.size() < 2) {
+        throw std::invalid_argument("Dataset topology needs at least an input and an output layer");
+    }
+    if (m_inputs.size() != m_sampleCount * m_inputCount || m_targets.size() != m_sampleCount * m_targetCount) {
+        throw std::invalid_argument("Dataset inputs and targets do not match the topology");
+    }
+}
+
+Dataset Dataset::load(const std::string &filename, const unsigned threadCount) {
+    if (BinaryDataset::isBinaryDataset(filename)) {
+        const BinaryDataset binary(filename);
+        // the constructor checked that these arrays fit in the file, so the products do not wrap
+        const std::size_t inputValues = binary.getSampleCount() * binary.getInputCount();
+        const std::size_t targetValues = binary.getSampleCount() * binary.getTargetCount();
+        if (binary.getDataType() == BinaryDataset::DataType::Float32) {
+            const float *inputs = binary.getInputs<float>();
+            const float *targets = binary.getTargets<float>();
+            return {binary.getTopology(), std::vector<float>(inputs, inputs + inputValues),
+                    std::vector<float>(targets, targets + targetValues)};
+        }
+        std::vector<float> inputs(inputValues), targets(targetValues);
+        const double *srcInputs = binary.getInputs<double>();
+        const double *srcTargets = binary.getTargets<double>();
+        for (std::size_t k = 0; k < inputValues; ++k) inputs[k] = static_cast<float>(srcInputs[k]);
+        for (std::size_t k = 0; k < targetValues; ++k) targets[k] = static_cast<float>(srcTargets[k]);
+        return {binary.getTopology(), std::move(inputs), std::move(targets)};
+    }
+
+    const MappedFile file(filename);
+    const auto *begin = reinterpret_cast<const char *>(file.data());
+    TextParser parser(begin, begin + file.size());
+    std::vector<unsigned> topology;
+    parser.readTopology(topology);
+    if (topology.size() < 2) {
+        throw std::runtime_error("No topology line in training data file: " + filename);
+    }
+
+    std::vector<float> inputs, targets;
+    parser.readSamples(topology.front(), topology.back(), inputs, targets, threadCount);
+    return {std::move(topology), std::move(inputs), std::move(targets)};
+}
+
+void Dataset::gatherBatch(const std::size_t *indices, const std::size_t count, float *inputs, float *targets) const {
+    for (std::size_t b = 0; b < count; ++b) {
+        assert(indices[b] < m_sampleCount);
+        std::memcpy(inputs + b * m_inputCount, getInputs(indices[b]), m_inputCount * sizeof(float));
+        std::memcpy(targets + b * m_targetCount, getTargets(indices[b]), m_targetCount * sizeof(float));
+    }
+}
+
+std::pair<Dataset, Dataset> Dataset::split(const double validationFraction, const std::uint64_t seed) const {
+    if (validationFraction < 0.0 || validationFraction >= 1.0) {
+        throw std::invalid_argument("Validation fraction must be in [0, 1)");
+    }
+    std::vector<std::size_t> order;
+    sampleOrder(order, true, seed, 0);
+    const auto validationCount =
+        static_cast<std::size_t>(std::floor(validationFraction * static_cast<double>(m_sampleCount)));
+    const std::size_t trainingCount = m_sampleCount - validationCount;
+    return {subset(order.data(), trainingCount), subset(order.data() + trainingCount, validationCount)};
+}
+
+Dataset Dataset::subset(const std::size_t *indices, const std::size_t count) const {
+    std::vector<float> inputs(count * m_inputCount), targets(count * m_targetCount);
+    gatherBatch(indices, count, inputs.data(), targets.data());
+    return {m_topology, std::move(inputs), std::move(targets)};
+}
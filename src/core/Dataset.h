@@ -0,0 +1,53 @@
+//
+// Training samples held in memory as contiguous float arrays.
+//
+
+#ifndef XORGATE_NEURALNETWORK_DATASET_H
+#define XORGATE_NEURALNETWORK_DATASET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "SampleSource.h"
+
+// A Dataset is loaded once and then iterated any number of epochs without touching the file
+// again. Inputs and targets are row-major (one sample per row), so a run of samples is already a
+// batch for Net::trainBatch; shuffled batches are gathered with sampleOrder + gatherBatch.
+class Dataset : public SampleSource {
+public:
+    Dataset(std::vector<unsigned> topology, std::vector<float> inputs, std::vector<float> targets);
+
+    // reads every sample of a text or binary training data file; large text files are parsed on
+    // threadCount threads (0: one per hardware thread)
+    // throws std::runtime_error if the file cannot be read or has no topology line
+    static Dataset load(const std::string &filename, unsigned threadCount = 0);
+
+    [[nodiscard]] const std::vector<unsigned> &getTopology() const { return m_topology; }
+    [[nodiscard]] std::size_t getSampleCount() const override { return m_sampleCount; }
+    [[nodiscard]] std::size_t getInputCount() const override { return m_inputCount; }
+    [[nodiscard]] std::size_t getTargetCount() const override { return m_targetCount; }
+
+    [[nodiscard]] const float *getInputs(std::size_t sample = 0) const { return m_inputs.data() + sample * m_inputCount; }
+    [[nodiscard]] const float *getTargets(std::size_t sample = 0) const { return m_targets.data() + sample * m_targetCount; }
+
+    void gatherBatch(const std::size_t *indices, std::size_t count, float *inputs, float *targets) const override;
+
+    // Splits off a random validationFraction of the samples; returns {training, validation}.
+    // Shuffling first matters for files sorted by label, like digits.txt.
+    [[nodiscard]] std::pair<Dataset, Dataset> split(double validationFraction, std::uint64_t seed) const;
+
+private:
+    [[nodiscard]] Dataset subset(const std::size_t *indices, std::size_t count) const;
+
+    std::vector<unsigned> m_topology;
+    std::size_t m_inputCount;
+    std::size_t m_targetCount;
+    std::size_t m_sampleCount;
+    std::vector<float> m_inputs;  // [sampleCount x inputCount]
+    std::vector<float> m_targets; // [sampleCount x targetCount]
+};
+
+
+#endif //XORGATE_NEURALNETWORK_DATASET_H
@@ -0,0 +1,270 @@
+//
+// Dense (fully connected) layer with contiguous parameter storage.
+//
+
+#include "DenseLayer.h"
+#include "Kernels.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+// element offset of a state array, nullptr for a slot the optimizer does not use
+template<typename U, std::size_t N>
+U *stateAt(const std::array<std::span<U>, N> &states, const std::size_t slot, const std::size_t offset) {
+    return states[slot].empty() ? nullptr : states[slot].data() + offset;
+}
+
+}
+
+template<typename T>
+DenseLayer<T>::DenseLayer(const std::size_t numInputs, const std::size_t numOutputs, const Activation activation)
+    : m_numInputs(numInputs)
+    , m_numOutputs(numOutputs)
+    , m_activation(activation)
+{
+}
+
+template<typename T>
+std::size_t DenseLayer<T>::arenaBytes(const std::size_t numInputs, const std::size_t numOutputs,
+                                      const std::size_t stateCount, const bool masterWeights) {
+    const std::size_t weightCount = numInputs * numOutputs;
+    // weights and biases with their state arrays, outputs and gradients
+    std::size_t bytes = (1 + stateCount) * Arena::bytesFor<T>(weightCount)
+                        + (3 + stateCount) * Arena::bytesFor<T>(numOutputs);
+    if (masterWeights) {
+        bytes += (1 + stateCount) * (Arena::bytesFor<double>(weightCount) + Arena::bytesFor<double>(numOutputs));
+    }
+    return bytes;
+}
+
+template<typename T>
+void DenseLayer<T>::place(Arena &arena, const std::size_t stateCount, const bool masterWeights) {
+    assert(stateCount >= 1 && stateCount <= maxStateCount);
+    const auto placeArray = [&arena]<typename U>(std::span<U> &array, const std::size_t count) {
+        const std::span<U> placed = arena.allocate<U>(count);
+        std::copy(array.begin(), array.end(), placed.begin());
+        array = placed;
+    };
+    const auto placeStates = [&]<typename U>(std::array<std::span<U>, maxStateCount> &states,
+                                             const std::size_t count) {
+        for (std::size_t slot = 0; slot < maxStateCount; ++slot) {
+            if (slot < stateCount) {
+                placeArray(states[slot], count);
+            } else {
+                states[slot] = {};
+            }
+        }
+    };
+    const std::size_t weightCount = m_numInputs * m_numOutputs;
+    placeArray(m_weights, weightCount);
+    placeArray(m_biases, m_numOutputs);
+    placeStates(m_weightStates, weightCount);
+    placeStates(m_biasStates, m_numOutputs);
+    m_stateCount = stateCount;
+    placeArray(m_outputs, m_numOutputs);
+    placeArray(m_gradients, m_numOutputs);
+
+    if (!masterWeights) {
+        m_masterWeights = {};
+        m_masterBiases = {};
+        m_masterWeightStates = {};
+        m_masterBiasStates = {};
+        return;
+    }
+    const bool newMasters = !hasMasterWeights();
+    placeArray(m_masterWeights, weightCount);
+    placeArray(m_masterBiases, m_numOutputs);
+    placeStates(m_masterWeightStates, weightCount);
+    placeStates(m_masterBiasStates, m_numOutputs);
+    if (newMasters) {
+        std::copy(m_weights.begin(), m_weights.end(), m_masterWeights.begin());
+        std::copy(m_biases.begin(), m_biases.end(), m_masterBiases.begin());
+        for (std::size_t slot = 0; slot < stateCount; ++slot) {
+            std::copy(m_weightStates[slot].begin(), m_weightStates[slot].end(), m_masterWeightStates[slot].begin());
+            std::copy(m_biasStates[slot].begin(), m_biasStates[slot].end(), m_masterBiasStates[slot].begin());
+        }
+    }
+}
+
+template<typename T>
+void DenseLayer<T>::feedForward(const std::span<const T> prevOutputs) {
+    assert(prevOutputs.size() == m_numInputs);
+
+    // outputs = W * prevOutputs, then the bias neuron (always 1.0) and the transfer function
+    kernels::gemv(kernels::Transpose::No, m_numOutputs, m_numInputs, T(1), m_weights.data(), m_numInputs,
+                  prevOutputs.data(), T(0), m_outputs.data());
+    kernels::biasActivate(m_activation, 1, m_numOutputs, m_biases.data(), m_outputs.data());
+}
+
+template<typename T>
+void DenseLayer<T>::calculateOutputGradients(const std::vector<double> &targetValues) {
+    assert(targetValues.size() >= m_numOutputs);
+
+    for (std::size_t o = 0; o < m_numOutputs; ++o) {
+        m_gradients[o] = static_cast<T>(targetValues[o]) - m_outputs[o];
+    }
+    kernels::activationGradient(m_activation, m_numOutputs, m_outputs.data(), m_gradients.data());
+}
+
+template<typename T>
+void DenseLayer<T>::calculateHiddenGradients(const DenseLayer &nextLayer) {
+    assert(nextLayer.m_numInputs == m_numOutputs);
+
+    // sum of the derivatives of the weights of the next layer: W_next^T * gradients_next
+    kernels::gemv(kernels::Transpose::Yes, nextLayer.m_numOutputs, m_numOutputs, T(1), nextLayer.m_weights.data(),
+                  nextLayer.m_numInputs, nextLayer.m_gradients.data(), T(0), m_gradients.data());
+    kernels::activationGradient(m_activation, m_numOutputs, m_outputs.data(), m_gradients.data());
+}
+
+template<typename T>
+void DenseLayer<T>::updateWeights(const std::span<const T> prevOutputs, const Optimizer &optimizer,
+                                  const std::uint64_t step) {
+    assert(prevOutputs.size() == m_numInputs);
+    assert(optimizer.stateCount() == m_stateCount);
+
+    // the gradients of a row are the neuron's gradient times the inputs, and 1.0 for the bias
+    const T one = T(1);
+    for (std::size_t o = 0; o < m_numOutputs; ++o) {
+        const double gradient = static_cast<double>(m_gradients[o]);
+        const std::size_t row = o * m_numInputs;
+        if (hasMasterWeights()) {
+            optimizer.applyMaster(step, m_numInputs, gradient, prevOutputs.data(), &m_masterWeights[row],
+                                  stateAt(m_masterWeightStates, 0, row), stateAt(m_masterWeightStates, 1, row),
+                                  &m_weights[row], stateAt(m_weightStates, 0, row), stateAt(m_weightStates, 1, row));
+            optimizer.applyMaster(step, 1, gradient, &one, &m_masterBiases[o], stateAt(m_masterBiasStates, 0, o),
+                                  stateAt(m_masterBiasStates, 1, o), &m_biases[o], stateAt(m_biasStates, 0, o),
+                                  stateAt(m_biasStates, 1, o));
+            continue;
+        }
+        optimizer.apply(step, m_numInputs, gradient, prevOutputs.data(), &m_weights[row],
+                        stateAt(m_weightStates, 0, row), stateAt(m_weightStates, 1, row));
+        optimizer.apply(step, 1, gradient, &one, &m_biases[o], stateAt(m_biasStates, 0, o),
+                        stateAt(m_biasStates, 1, o));
+    }
+}
+
+template<typename T>
+void DenseLayer<T>::feedForwardBatch(const T *prevOutputs, const std::size_t batchSize, T *outputs) const {
+    if (batchSize == 1) {
+        // a single sample (e.g. one prediction) is a matrix-vector product, no need to pack for gemm
+        kernels::gemv(kernels::Transpose::No, m_numOutputs, m_numInputs, T(1), m_weights.data(), m_numInputs,
+                      prevOutputs, T(0), outputs);
+        kernels::biasActivate(m_activation, 1, m_numOutputs, m_biases.data(), outputs);
+        return;
+    }
+    kernels::gemm(kernels::Transpose::No, kernels::Transpose::Yes, batchSize, m_numOutputs, m_numInputs,
+                  T(1), prevOutputs, m_numInputs, m_weights.data(), m_numInputs, T(0), outputs, m_numOutputs);
+    kernels::biasActivate(m_activation, batchSize, m_numOutputs, m_biases.data(), outputs);
+}
+
+template<typename T>
+void DenseLayer<T>::calculateOutputGradientsBatch(const T *outputs, const float *targetValues,
+                                                  const std::size_t batchSize, T *gradients) const {
+    const std::size_t count = batchSize * m_numOutputs;
+    for (std::size_t k = 0; k < count; ++k) {
+        gradients[k] = static_cast<T>(targetValues[k]) - outputs[k];
+    }
+    kernels::activationGradient(m_activation, count, outputs, gradients);
+}
+
+template<typename T>
+void DenseLayer<T>::calculateHiddenGradientsBatch(const DenseLayer &nextLayer, const T *nextGradients,
+                                                  const T *outputs, const std::size_t batchSize,
+                                                  T *gradients) const {
+    assert(nextLayer.m_numInputs == m_numOutputs);
+
+    kernels::gemm(kernels::Transpose::No, kernels::Transpose::No, batchSize, m_numOutputs, nextLayer.m_numOutputs,
+                  T(1), nextGradients, nextLayer.m_numOutputs, nextLayer.m_weights.data(), nextLayer.m_numInputs,
+                  T(0), gradients, m_numOutputs);
+    kernels::activationGradient(m_activation, batchSize * m_numOutputs, outputs, gradients);
+}
+
+template<typename T>
+void DenseLayer<T>::accumulateGradientsBatch(const T *prevOutputs, const T *gradients,
+                                             const std::size_t batchSize, const T scale,
+                                             T *weightGradients, T *biasGradients) const {
+    for (std::size_t o = 0; o < m_numOutputs; ++o) {
+        biasGradients[o] = T(0);
+    }
+
+    // weightGradients = scale * gradients^T * prevOutputs, the scaled sum of the per-sample outer products
+    kernels::gemm(kernels::Transpose::Yes, kernels::Transpose::No, m_numOutputs, m_numInputs, batchSize, scale,
+                  gradients, m_numOutputs, prevOutputs, m_numInputs, T(0), weightGradients, m_numInputs);
+    for (std::size_t b = 0; b < batchSize; ++b) {
+        kernels::axpy(m_numOutputs, scale, gradients + b * m_numOutputs, biasGradients);
+    }
+}
+
+template<typename T>
+void DenseLayer<T>::applyGradients(const T *weightGradients, const T *biasGradients, const Optimizer &optimizer,
+                                   const std::uint64_t step) {
+    assert(optimizer.stateCount() == m_stateCount);
+    if (hasMasterWeights()) {
+        optimizer.applyMaster(step, m_weights.size(), 1.0, weightGradients, m_masterWeights.data(),
+                              stateAt(m_masterWeightStates, 0, 0), stateAt(m_masterWeightStates, 1, 0),
+                              m_weights.data(), stateAt(m_weightStates, 0, 0), stateAt(m_weightStates, 1, 0));
+        optimizer.applyMaster(step, m_biases.size(), 1.0, biasGradients, m_masterBiases.data(),
+                              stateAt(m_masterBiasStates, 0, 0), stateAt(m_masterBiasStates, 1, 0),
+                              m_biases.data(), stateAt(m_biasStates, 0, 0), stateAt(m_biasStates, 1, 0));
+        return;
+    }
+    optimizer.apply(step, m_weights.size(), 1.0, weightGradients, m_weights.data(), stateAt(m_weightStates, 0, 0),
+                    stateAt(m_weightStates, 1, 0));
+    optimizer.apply(step, m_biases.size(), 1.0, biasGradients, m_biases.data(), stateAt(m_biasStates, 0, 0),
+                    stateAt(m_biasStates, 1, 0));
+}
+
+template<typename T>
+void DenseLayer<T>::setWeight(const std::size_t output, const std::size_t input, const double value) {
+    m_weights[output * m_numInputs + input] = static_cast<T>(value);
+    if (hasMasterWeights()) {
+        m_masterWeights[output * m_numInputs + input] = value;
+    }
+}
+
+template<typename T>
+void DenseLayer<T>::setBias(const std::size_t output, const double value) {
+    m_biases[output] = static_cast<T>(value);
+    if (hasMasterWeights()) {
+        m_masterBiases[output] = value;
+    }
+}
+
+template<typename T>
+void DenseLayer<T>::setParameters(const double *weights, const double *biases) {
+    std::transform(weights, weights + m_weights.size(), m_weights.begin(), [](double v) { return static_cast<T>(v); });
+    std::transform(biases, biases + m_biases.size(), m_biases.begin(), [](double v) { return static_cast<T>(v); });
+
+    // the masters take the full double values, not the rounded working copies
+    if (hasMasterWeights()) {
+        std::copy(weights, weights + m_weights.size(), m_masterWeights.begin());
+        std::copy(biases, biases + m_biases.size(), m_masterBiases.begin());
+    }
+}
+
+template<typename T>
+void DenseLayer<T>::setState(const std::size_t slot, const double *weightState, const double *biasState) {
+    assert(slot < m_stateCount);
+    const std::span<T> weights = m_weightStates[slot];
+    const std::span<T> biases = m_biasStates[slot];
+    std::transform(weightState, weightState + weights.size(), weights.begin(), [](double v) { return static_cast<T>(v); });
+    std::transform(biasState, biasState + biases.size(), biases.begin(), [](double v) { return static_cast<T>(v); });
+    if (hasMasterWeights()) {
+        std::copy(weightState, weightState + weights.size(), m_masterWeightStates[slot].begin());
+        std::copy(biasState, biasState + biases.size(), m_masterBiasStates[slot].begin());
+    }
+}
+
+template<typename T>
+void DenseLayer<T>::resetState() {
+    for (std::size_t slot = 0; slot < m_stateCount; ++slot) {
+        std::fill(m_weightStates[slot].begin(), m_weightStates[slot].end(), T(0));
+        std::fill(m_biasStates[slot].begin(), m_biasStates[slot].end(), T(0));
+        std::fill(m_masterWeightStates[slot].begin(), m_masterWeightStates[slot].end(), 0.0);
+        std::fill(m_masterBiasStates[slot].begin(), m_masterBiasStates[slot].end(), 0.0);
+    }
+}
+
+template class DenseLayer<float>;
+template class DenseLayer<double>;
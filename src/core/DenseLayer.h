@@ -0,0 +1,158 @@
+//
+// Dense (fully connected) layer with contiguous parameter storage.
+//
+
+#ifndef XORGATE_NEURALNETWORK_DENSELAYER_H
+#define XORGATE_NEURALNETWORK_DENSELAYER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Activation.h"
+#include "Arena.h"
+#include "Optimizer.h"
+
+// A DenseLayer owns everything between the previous layer and this one: the weights of all
+// incoming connections, the bias weights, the optimizer state of both (one or two arrays each, see
+// Optimizer::stateCount) and the neuron outputs/gradients.
+// Weights are stored row-major with one row per output neuron, so computing a neuron walks
+// its inputs sequentially instead of hopping through the previous layer's neurons.
+//
+// T is the scalar type of the parameters and of all computations (float or double). A float
+// layer can additionally keep double master weights: the passes still run in float, but the
+// updates are accumulated in double, so small steps are not lost to float rounding.
+//
+// The arrays live in the arena of the net that owns the layer (see place), so a layer is only a
+// set of views: copying one shares its arrays until the copy is placed in another arena.
+template<typename T>
+class DenseLayer {
+public:
+    // the layer has no arrays until it is placed
+    DenseLayer(std::size_t numInputs, std::size_t numOutputs, Activation activation = Activation::Tanh);
+
+    static constexpr std::size_t maxStateCount = 2;
+
+    // arena bytes the arrays of a layer of this shape take up
+    [[nodiscard]] static std::size_t arenaBytes(std::size_t numInputs, std::size_t numOutputs, std::size_t stateCount,
+                                                bool masterWeights);
+
+    // Takes this layer's arrays from arena, with stateCount optimizer state arrays per parameter
+    // array. Values of arrays placed before are copied over; new arrays start at zero, except
+    // master copies, which start from the working parameters and state.
+    void place(Arena &arena, std::size_t stateCount, bool masterWeights);
+
+    [[nodiscard]] std::size_t getInputCount() const { return m_numInputs; }
+    [[nodiscard]] std::size_t getOutputCount() const { return m_numOutputs; }
+
+    [[nodiscard]] Activation getActivation() const { return m_activation; }
+    void setActivation(Activation activation) { m_activation = activation; }
+
+    // calculates the output values from the outputs of the previous layer (bias excluded)
+    void feedForward(std::span<const T> prevOutputs);
+
+    // gradients of an output layer, using the target values
+    void calculateOutputGradients(const std::vector<double> &targetValues);
+
+    // gradients of a hidden layer, using the gradients and incoming weights of the next layer
+    void calculateHiddenGradients(const DenseLayer &nextLayer);
+
+    // applies update number step of optimizer to every incoming weight, with the gradient of a
+    // weight being the gradient of its neuron times its input
+    void updateWeights(std::span<const T> prevOutputs, const Optimizer &optimizer, std::uint64_t step);
+
+    // Batched passes. Every buffer is row-major with one row per sample, so the passes are the
+    // matrix products outputs = prev * W^T, prevGradients = gradients * W and
+    // weightGradients = gradients^T * prev.
+
+    // outputs[batchSize x numOutputs] from prevOutputs[batchSize x numInputs]
+    void feedForwardBatch(const T *prevOutputs, std::size_t batchSize, T *outputs) const;
+
+    // gradients[batchSize x numOutputs] of an output layer from its outputs and the targets
+    void calculateOutputGradientsBatch(const T *outputs, const float *targetValues,
+                                       std::size_t batchSize, T *gradients) const;
+
+    // gradients[batchSize x numOutputs] of a hidden layer from the gradients of the next layer
+    void calculateHiddenGradientsBatch(const DenseLayer &nextLayer, const T *nextGradients,
+                                       const T *outputs, std::size_t batchSize,
+                                       T *gradients) const;
+
+    // sums scale * gradient * input over the batch into weightGradients[numOutputs x numInputs]
+    // and biasGradients[numOutputs]; scale = 1 / batchSize gives the batch average, a smaller
+    // scale lets several shards of one batch be summed into that average
+    void accumulateGradientsBatch(const T *prevOutputs, const T *gradients,
+                                  std::size_t batchSize, T scale, T *weightGradients,
+                                  T *biasGradients) const;
+
+    // applies update number step of optimizer from the averaged gradients, the batch version of updateWeights
+    void applyGradients(const T *weightGradients, const T *biasGradients, const Optimizer &optimizer,
+                        std::uint64_t step);
+
+    // double master weights (only useful for float layers), enabled by placing the layer with them
+    [[nodiscard]] bool hasMasterWeights() const { return !m_masterWeights.empty(); }
+
+    // weight of the connection from input neuron `input` to output neuron `output`
+    [[nodiscard]] T getWeight(std::size_t output, std::size_t input) const {
+        return m_weights[output * m_numInputs + input];
+    }
+    [[nodiscard]] T getBias(std::size_t output) const { return m_biases[output]; }
+    // the first optimizer state of a weight or bias; for momentum SGD its last change
+    [[nodiscard]] T getDeltaWeight(std::size_t output, std::size_t input) const {
+        return m_weightStates[0][output * m_numInputs + input];
+    }
+    [[nodiscard]] T getDeltaBias(std::size_t output) const { return m_biasStates[0][output]; }
+
+    // whole parameter arrays, laid out like the members below
+    [[nodiscard]] std::span<const T> getWeights() const { return m_weights; }
+    [[nodiscard]] std::span<const T> getBiases() const { return m_biases; }
+    [[nodiscard]] std::size_t getStateCount() const { return m_stateCount; }
+    [[nodiscard]] std::span<const T> getWeightState(std::size_t slot) const { return m_weightStates[slot]; }
+    [[nodiscard]] std::span<const T> getBiasState(std::size_t slot) const { return m_biasStates[slot]; }
+
+    // the master copies, empty unless enabled
+    [[nodiscard]] std::span<const double> getMasterWeights() const { return m_masterWeights; }
+    [[nodiscard]] std::span<const double> getMasterBiases() const { return m_masterBiases; }
+    [[nodiscard]] std::span<const double> getMasterWeightState(std::size_t slot) const {
+        return m_masterWeightStates[slot];
+    }
+    [[nodiscard]] std::span<const double> getMasterBiasState(std::size_t slot) const {
+        return m_masterBiasStates[slot];
+    }
+
+    [[nodiscard]] std::span<const T> getOutputs() const { return m_outputs; }
+    [[nodiscard]] std::span<const T> getGradients() const { return m_gradients; }
+
+    void setWeight(std::size_t output, std::size_t input, double value);
+    void setBias(std::size_t output, double value);
+
+    // replace all weights and biases, or one optimizer state array of each, at once
+    void setParameters(const double *weights, const double *biases);
+    void setState(std::size_t slot, const double *weightState, const double *biasState);
+    // zeroes the optimizer state, e.g. when the update rule changes
+    void resetState();
+
+private:
+    std::size_t m_numInputs;
+    std::size_t m_numOutputs;
+    Activation m_activation; // transfer function of this layer's neurons
+    std::span<T> m_weights;      // [numOutputs x numInputs], row-major
+    std::span<T> m_biases;       // [numOutputs], weights of the previous layer's bias neuron
+    std::size_t m_stateCount = 0;
+    std::array<std::span<T>, maxStateCount> m_weightStates; // optimizer state, laid out like m_weights
+    std::array<std::span<T>, maxStateCount> m_biasStates;
+    std::span<T> m_outputs;
+    std::span<T> m_gradients;
+
+    // master copies of the parameter and state arrays above, empty unless enabled
+    std::span<double> m_masterWeights;
+    std::span<double> m_masterBiases;
+    std::array<std::span<double>, maxStateCount> m_masterWeightStates;
+    std::array<std::span<double>, maxStateCount> m_masterBiasStates;
+};
+
+extern template class DenseLayer<float>;
+extern template class DenseLayer<double>;
+
+
+#endif //XORGATE_NEURALNETWORK_DENSELAYER_H
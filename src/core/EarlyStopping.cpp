@@ -0,0 +1,94 @@
+//
+// Stops training once the error on held-out samples no longer improves.
+//
+
+#include "EarlyStopping.h"
+#include "SampleSource.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// samples predicted at once; large enough for the batched kernels, small enough for the cache
+constexpr std::size_t evaluationBatchSize = 256;
+
+}
+
+template<typename T>
+double validationError(const BasicNet<T> &net, const SampleSource &source) {
+    const std::size_t sampleCount = source.getSampleCount();
+    if (sampleCount == 0) {
+        return 0.0;
+    }
+    const std::size_t numInputs = source.getInputCount();
+    const std::size_t numOutputs = source.getTargetCount();
+    const std::size_t batchSize = std::min(evaluationBatchSize, sampleCount);
+    std::vector<std::size_t> indices(batchSize);
+    std::vector<float> inputs(batchSize * numInputs);
+    std::vector<float> targets(batchSize * numOutputs);
+    std::vector<T> converted;
+    std::vector<T> outputs(batchSize * numOutputs);
+
+    double errorSum = 0.0;
+    for (std::size_t first = 0; first < sampleCount; first += batchSize) {
+        const std::size_t count = std::min(batchSize, sampleCount - first);
+        std::iota(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(count), first);
+        source.gatherBatch(indices.data(), count, inputs.data(), targets.data());
+        if constexpr (std::is_same_v<T, float>) {
+            net.predict(inputs.data(), count, outputs.data());
+        } else {
+            converted.assign(inputs.begin(), inputs.begin() + static_cast<std::ptrdiff_t>(count * numInputs));
+            net.predict(converted.data(), count, outputs.data());
+        }
+        for (std::size_t s = 0; s < count; ++s) {
+            double error = 0.0;
+            for (std::size_t o = 0; o < numOutputs; ++o) {
+                const double delta = static_cast<double>(targets[s * numOutputs + o]) -
+                                     static_cast<double>(outputs[s * numOutputs + o]);
+                error += delta * delta;
+            }
+            errorSum += std::sqrt(error / static_cast<double>(numOutputs));
+        }
+    }
+    return errorSum / static_cast<double>(sampleCount);
+}
+
+template<typename T>
+EarlyStopping<T>::EarlyStopping(const std::size_t patience, const double minDelta)
+    : m_patience(patience)
+    , m_minDelta(minDelta)
+{
+}
+
+template<typename T>
+bool EarlyStopping<T>::update(const BasicNet<T> &net, const double error) {
+    const std::size_t epoch = m_epochCount++;
+    if (!m_best || error < m_bestError - m_minDelta) {
+        m_bestError = error;
+        m_bestEpoch = epoch;
+        if (m_best) {
+            *m_best = net;
+        } else {
+            m_best.emplace(net);
+        }
+        return false;
+    }
+    return m_patience > 0 && epoch - m_bestEpoch >= m_patience;
+}
+
+template<typename T>
+bool EarlyStopping<T>::restoreBest(BasicNet<T> &net) const {
+    if (!m_best) {
+        return false;
+    }
+    net = *m_best;
+    return true;
+}
+
+template double validationError(const BasicNet<float> &net, const SampleSource &source);
+template double validationError(const BasicNet<double> &net, const SampleSource &source);
+template class EarlyStopping<float>;
+template class EarlyStopping<double>;
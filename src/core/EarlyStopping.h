@@ -0,0 +1,55 @@
+//
+// Stops training once the error on held-out samples no longer improves.
+//
+
+#ifndef XORGATE_NEURALNETWORK_EARLYSTOPPING_H
+#define XORGATE_NEURALNETWORK_EARLYSTOPPING_H
+
+#include <cstddef>
+#include <optional>
+#include "Net.h"
+
+class SampleSource;
+
+// Average RMS error of net over all samples of source, the same measure as the recent average
+// error of training, computed with predict and so without changing the net. Returns 0 for an
+// empty source.
+template<typename T>
+double validationError(const BasicNet<T> &net, const SampleSource &source);
+
+// EarlyStopping watches the validation error after every epoch. It keeps a copy of the net from
+// the best epoch so far and says when to stop: after patience epochs in a row that did not
+// lower the best error by more than minDelta. restoreBest then rolls the net back to that epoch,
+// so the epochs spent past the optimum cost time but not accuracy.
+template<typename T>
+class EarlyStopping {
+public:
+    // patience 0 never stops, but still remembers the best net
+    explicit EarlyStopping(std::size_t patience, double minDelta = 0.0);
+
+    // records the validation error of net after one more epoch; returns true to stop training
+    bool update(const BasicNet<T> &net, double error);
+
+    // replaces net by the best one seen (parameters and optimizer state); returns false and
+    // leaves net alone if update was never called
+    bool restoreBest(BasicNet<T> &net) const;
+
+    [[nodiscard]] double getBestError() const { return m_bestError; }
+    // epochs recorded before the best one, i.e. the index of the best epoch counting from 0
+    [[nodiscard]] std::size_t getBestEpoch() const { return m_bestEpoch; }
+    [[nodiscard]] std::size_t getEpochCount() const { return m_epochCount; }
+
+private:
+    std::size_t m_patience;
+    double m_minDelta;
+    double m_bestError = 0.0;
+    std::size_t m_bestEpoch = 0;
+    std::size_t m_epochCount = 0;
+    std::optional<BasicNet<T>> m_best;
+};
+
+extern template class EarlyStopping<float>;
+extern template class EarlyStopping<double>;
+
+
+#endif //XORGATE_NEURALNETWORK_EARLYSTOPPING_H
@@ -0,0 +1,141 @@
+//
+// Asynchronous lock-free ("Hogwild") training on several threads.
+//
+
+#include "HogwildTrainer.h"
+#include <algorithm>
+#include <type_traits>
+
+HogwildTrainer::HogwildTrainer(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_workers = std::vector<Worker>(threadCount);
+    m_threads.reserve(threadCount - 1);
+    for (std::size_t slice = 1; slice < threadCount; ++slice) {
+        m_threads.emplace_back(&HogwildTrainer::workerLoop, this, slice);
+    }
+}
+
+HogwildTrainer::~HogwildTrainer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobPosted.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+template<typename T>
+bool HogwildTrainer::trainEpoch(BasicNet<T> &net, const SampleSource &dataset, const std::vector<std::size_t> &order,
+                                const std::size_t batchSize, const std::atomic<bool> *cancel) {
+    if (order.empty() || batchSize == 0) {
+        return true;
+    }
+
+    // never more slices than batches, an idle thread would only add wake-up cost
+    const std::size_t batchCount = (order.size() + batchSize - 1) / batchSize;
+    const std::size_t sliceCount = std::min(m_workers.size(), batchCount);
+
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job.generation++;
+        m_job.net = &net;
+        m_job.runSlice = &HogwildTrainer::runSlice<T>;
+        m_job.dataset = &dataset;
+        m_job.order = order.data();
+        m_job.sampleCount = order.size();
+        m_job.batchSize = batchSize;
+        m_job.cancel = cancel;
+        m_job.sliceCount = sliceCount;
+        job = m_job;
+    }
+    if (sliceCount > 1) {
+        m_jobPosted.notify_all();
+    }
+
+    runSlice<T>(job, 0);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sliceFinished.wait(lock, [&] {
+            for (std::size_t slice = 1; slice < sliceCount; ++slice) {
+                if (m_workers[slice].finished != job.generation) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    bool completed = true;
+    for (std::size_t slice = 0; slice < sliceCount; ++slice) {
+        net.recordErrors(m_workers[slice].sampleErrors);
+        completed = completed && !m_workers[slice].cancelled;
+    }
+    return completed;
+}
+
+void HogwildTrainer::workerLoop(const std::size_t slice) {
+    std::uint64_t seen = 0;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobPosted.wait(lock, [&] { return m_stop || m_job.generation != seen; });
+            if (m_stop) {
+                return;
+            }
+            job = m_job;
+            seen = job.generation;
+        }
+        if (slice < job.sliceCount) {
+            (this->*job.runSlice)(job, slice);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_workers[slice].finished = job.generation;
+            }
+            m_sliceFinished.notify_all();
+        }
+    }
+}
+
+template<typename T>
+void HogwildTrainer::runSlice(const Job &job, const std::size_t slice) {
+    auto &net = *static_cast<BasicNet<T> *>(job.net);
+    const SampleSource &dataset = *job.dataset;
+    Worker &worker = m_workers[slice];
+    typename BasicNet<T>::Workspace *workspace;
+    if constexpr (std::is_same_v<T, float>) {
+        workspace = &worker.floatWorkspace;
+    } else {
+        workspace = &worker.doubleWorkspace;
+    }
+    worker.sampleErrors.clear();
+    worker.cancelled = false;
+    worker.inputs.resize(job.batchSize * dataset.getInputCount());
+    worker.targets.resize(job.batchSize * dataset.getTargetCount());
+
+    // every slice is a contiguous run of the epoch's sample order
+    const std::size_t *indices = job.order + job.sampleCount * slice / job.sliceCount;
+    const std::size_t count = job.sampleCount * (slice + 1) / job.sliceCount - job.sampleCount * slice / job.sliceCount;
+    for (std::size_t first = 0; first < count; first += job.batchSize) {
+        if (job.cancel != nullptr && job.cancel->load(std::memory_order_relaxed)) {
+            worker.cancelled = true;
+            return;
+        }
+        const std::size_t n = std::min(job.batchSize, count - first);
+        dataset.gatherBatch(indices + first, n, worker.inputs.data(), worker.targets.data());
+        net.computeGradients(worker.inputs.data(), worker.targets.data(), n, T(1) / static_cast<T>(n), *workspace);
+        net.applyGradients(*workspace); // unsynchronized on purpose, see HogwildTrainer.h
+        worker.sampleErrors.insert(worker.sampleErrors.end(), workspace->sampleErrors.begin(),
+                                   workspace->sampleErrors.end());
+    }
+}
+
+template bool HogwildTrainer::trainEpoch(BasicNet<float> &, const SampleSource &, const std::vector<std::size_t> &,
+                                         std::size_t, const std::atomic<bool> *);
+template bool HogwildTrainer::trainEpoch(BasicNet<double> &, const SampleSource &, const std::vector<std::size_t> &,
+                                         std::size_t, const std::atomic<bool> *);
@@ -0,0 +1,87 @@
+//
+// Asynchronous lock-free ("Hogwild") training on several threads.
+//
+
+#ifndef XORGATE_NEURALNETWORK_HOGWILDTRAINER_H
+#define XORGATE_NEURALNETWORK_HOGWILDTRAINER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SampleSource.h"
+#include "Net.h"
+
+// Every thread trains on its own contiguous slice of the epoch's sample order and applies its
+// updates straight to the shared weights, without locks and without waiting for the other threads.
+// The threads therefore read weights that are being written and overwrite each other's momentum
+// terms. This is the intended trade-off: updates are never delayed, and for SGD the lost or
+// stale updates barely affect convergence. Unlike ParallelTrainer the result depends on thread
+// timing.
+//
+// The races are on individual aligned scalars in DenseLayer's parameter arrays, whose layout is
+// never changed during training; x86-64 and ARM64 do not tear such loads and stores. Nothing
+// else in the net (its vectors, the error statistics) is written concurrently, except the
+// optimizer's step counter, which is incremented atomically.
+//
+// Like ParallelTrainer, the calling thread trains slice 0 and the threadCount - 1 workers live as
+// long as the trainer, sleeping between epochs.
+class HogwildTrainer {
+public:
+    // threadCount == 0 uses one thread per hardware thread
+    explicit HogwildTrainer(unsigned threadCount = 0);
+    ~HogwildTrainer();
+
+    HogwildTrainer(const HogwildTrainer &) = delete;
+    HogwildTrainer &operator=(const HogwildTrainer &) = delete;
+
+    [[nodiscard]] unsigned getThreadCount() const { return static_cast<unsigned>(m_workers.size()); }
+
+    // Trains one epoch: the samples in order, batchSize at a time, split across the threads.
+    // Stops early, returning false, once cancel (if given) becomes true.
+    template<typename T>
+    bool trainEpoch(BasicNet<T> &net, const SampleSource &dataset, const std::vector<std::size_t> &order,
+                    std::size_t batchSize, const std::atomic<bool> *cancel = nullptr);
+
+private:
+    struct Job {
+        std::uint64_t generation = 0;
+        void *net = nullptr; // a BasicNet<float> or BasicNet<double>, see runSlice
+        void (HogwildTrainer::*runSlice)(const Job &, std::size_t) = nullptr;
+        const SampleSource *dataset = nullptr;
+        const std::size_t *order = nullptr;
+        std::size_t sampleCount = 0;
+        std::size_t batchSize = 0;
+        const std::atomic<bool> *cancel = nullptr;
+        std::size_t sliceCount = 0;
+    };
+
+    struct alignas(64) Worker {
+        BasicNet<float>::Workspace floatWorkspace;
+        BasicNet<double>::Workspace doubleWorkspace;
+        std::vector<float> inputs;
+        std::vector<float> targets;
+        std::vector<double> sampleErrors; // errors of this thread's samples, recorded after the epoch
+        bool cancelled = false;
+        std::uint64_t finished = 0; // generation whose slice this worker has finished
+    };
+
+    void workerLoop(std::size_t slice);
+    template<typename T>
+    void runSlice(const Job &job, std::size_t slice);
+
+    std::vector<Worker> m_workers; // m_workers[i] holds the state of slice i
+    std::vector<std::thread> m_threads; // m_threads[i] trains slice i + 1
+
+    std::mutex m_mutex; // guards m_job, m_stop and Worker::finished
+    std::condition_variable m_jobPosted;
+    std::condition_variable m_sliceFinished;
+    Job m_job;
+    bool m_stop = false;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_HOGWILDTRAINER_H
@@ -0,0 +1,58 @@
+//
+// Function tables through which Kernels.cpp dispatches to one instruction set.
+// Internal to the kernel implementation files.
+//
+
+#ifndef XORGATE_NEURALNETWORK_KERNELTABLE_H
+#define XORGATE_NEURALNETWORK_KERNELTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "Kernels.h"
+
+namespace kernels {
+
+template<typename T>
+struct KernelTable {
+    // number of elements the caller provides as packing workspace for gemm
+    std::size_t gemmWorkspaceSize;
+
+    void (*gemv)(Transpose transA, std::size_t m, std::size_t n, T alpha, const T *a, std::size_t lda,
+                 const T *x, T beta, T *y);
+    void (*gemm)(Transpose transA, Transpose transB, std::size_t m, std::size_t n, std::size_t k,
+                 T alpha, const T *a, std::size_t lda, const T *b, std::size_t ldb,
+                 T beta, T *c, std::size_t ldc, T *workspace);
+    T (*dot)(std::size_t n, const T *x, const T *y);
+    void (*axpy)(std::size_t n, T alpha, const T *x, T *y);
+    void (*momentumAxpy)(std::size_t n, T alpha, const T *x, T momentum, T *delta, T *w);
+    void (*nesterovAxpy)(std::size_t n, T alpha, const T *x, T momentum, T *delta, T *w);
+    void (*adamStep)(std::size_t n, T scale, const T *x, T beta1, T beta2, T stepSize, T epsilon, T *m, T *v, T *w);
+    void (*rmsPropStep)(std::size_t n, T scale, const T *x, T decay, T stepSize, T epsilon, T *s, T *w);
+    void (*biasActivate)(Activation activation, std::size_t rows, std::size_t cols, const T *bias, T *x);
+    void (*activationGradient)(Activation activation, std::size_t n, const T *outputs, T *gradients);
+};
+
+struct KernelTables {
+    const char *name;
+    KernelTable<float> f32;
+    KernelTable<double> f64;
+};
+
+struct Int8Kernel {
+    const char *name;
+    void (*gemvU8S8)(std::size_t m, std::size_t n, const std::int8_t *a, std::size_t lda,
+                     const std::uint8_t *x, std::int32_t *y);
+};
+
+// Each returns false when its instruction set was not compiled in (non-x86 targets or a
+// compiler without the needed flags); whether the CPU supports it is checked by the caller.
+bool sseKernels(KernelTables &tables);
+bool avx2Kernels(KernelTables &tables);
+bool avx512Kernels(KernelTables &tables);
+bool avx2Int8Kernel(Int8Kernel &kernel);
+bool vnniInt8Kernel(Int8Kernel &kernel);
+
+}
+
+
+#endif //XORGATE_NEURALNETWORK_KERNELTABLE_H
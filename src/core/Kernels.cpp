@@ -0,0 +1,262 @@
+//
+// Dense linear algebra kernels used by the layers: portable fallback and runtime dispatch.
+//
+
+#include "Kernels.h"
+#include "KernelTable.h"
+#include "KernelsImpl.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Portable fallback: the same blocked algorithms with one scalar per "vector"
+template<typename T>
+struct ScalarTraits {
+    using Scalar = T;
+    using Vector = T;
+    static constexpr std::size_t width = 1;
+    static constexpr std::size_t mr = 4;
+    static constexpr std::size_t nr = 4;
+
+    static Vector zero() { return T(0); }
+    static Vector set1(const Scalar s) { return s; }
+    static Vector load(const Scalar *p) { return *p; }
+    static void store(Scalar *p, const Vector v) { *p = v; }
+    static Vector add(const Vector a, const Vector b) { return a + b; }
+    static Vector mul(const Vector a, const Vector b) { return a * b; }
+    static Vector sub(const Vector a, const Vector b) { return a - b; }
+    static Vector div(const Vector a, const Vector b) { return a / b; }
+    static Vector sqrt(const Vector a) { return std::sqrt(a); }
+    static Vector min(const Vector a, const Vector b) { return a < b ? a : b; }
+    static Vector max(const Vector a, const Vector b) { return a > b ? a : b; }
+    static Vector maskPositive(const Vector cond, const Vector v) { return cond > T(0) ? v : T(0); }
+    static Vector fmadd(const Vector a, const Vector b, const Vector c) { return a * b + c; }
+    static Scalar reduce(const Vector v) { return v; }
+};
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool avx512 = false;
+    bool avx512Vnni = false; // with AVX-512BW
+};
+
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2");
+    features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    features.avx512 = __builtin_cpu_supports("avx512f");
+    features.avx512Vnni = features.avx512 && __builtin_cpu_supports("avx512bw")
+                          && __builtin_cpu_supports("avx512vnni");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int regs[4];
+    __cpuid(regs, 1);
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    features.sse2 = (regs[3] & (1 << 26)) != 0;
+    // the OS has to save the YMM (and for AVX-512 the ZMM/opmask) registers on context switches
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    __cpuidex(regs, 7, 0);
+    features.avx2 = fma && (regs[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+    features.avx512 = (regs[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+    features.avx512Vnni = features.avx512 && (regs[1] & (1 << 30)) != 0 && (regs[2] & (1 << 11)) != 0;
+#endif
+    return features;
+}
+
+kernels::KernelTables selectKernels() {
+    kernels::KernelTables scalar{"scalar", BlockedKernels<ScalarTraits<float>>::table(),
+                                 BlockedKernels<ScalarTraits<double>>::table()};
+    const CpuFeatures cpu = detectCpuFeatures();
+
+    const char *forced = std::getenv("NN_KERNELS");
+    const auto allowed = [forced](const char *name) {
+        return forced == nullptr || std::strcmp(forced, name) == 0;
+    };
+
+    kernels::KernelTables tables{};
+    if (cpu.avx512 && allowed("avx512") && kernels::avx512Kernels(tables)) return tables;
+    if (cpu.avx2 && allowed("avx2") && kernels::avx2Kernels(tables)) return tables;
+    if (cpu.sse2 && allowed("sse2") && kernels::sseKernels(tables)) return tables;
+    return scalar;
+}
+
+const kernels::KernelTables &active() {
+    static const kernels::KernelTables tables = selectKernels();
+    return tables;
+}
+
+void gemvU8S8Scalar(const std::size_t m, const std::size_t n, const std::int8_t *a, const std::size_t lda,
+                    const std::uint8_t *x, std::int32_t *y) {
+    for (std::size_t i = 0; i < m; ++i) {
+        const std::int8_t *row = a + i * lda;
+        std::int32_t sum = 0;
+        for (std::size_t j = 0; j < n; ++j) {
+            sum += static_cast<std::int32_t>(x[j]) * static_cast<std::int32_t>(row[j]);
+        }
+        y[i] = sum;
+    }
+}
+
+// The int8 kernel follows the float selection, so NN_KERNELS limits it too: VNNI only next to
+// the AVX-512 kernels, pmaddubsw next to AVX2 or AVX-512 (SSE2 has no byte multiply-add)
+kernels::Int8Kernel selectInt8Kernel() {
+    const CpuFeatures cpu = detectCpuFeatures();
+    const std::string_view isa = active().name;
+
+    kernels::Int8Kernel kernel{};
+    if (isa == "avx512" && cpu.avx512Vnni && kernels::vnniInt8Kernel(kernel)) return kernel;
+    if ((isa == "avx512" || isa == "avx2") && cpu.avx2 && kernels::avx2Int8Kernel(kernel)) return kernel;
+    return {"scalar", gemvU8S8Scalar};
+}
+
+const kernels::Int8Kernel &activeInt8() {
+    static const kernels::Int8Kernel kernel = selectInt8Kernel();
+    return kernel;
+}
+
+const kernels::KernelTable<float> &table(float) { return active().f32; }
+const kernels::KernelTable<double> &table(double) { return active().f64; }
+
+// packing buffer for gemm, one per thread so concurrent calls don't share it
+template<typename T>
+T *gemmWorkspace(const std::size_t size) {
+    thread_local std::vector<T> workspace;
+    if (workspace.size() < size) {
+        workspace.resize(size);
+    }
+    return workspace.data();
+}
+
+template<typename T>
+void gemmImpl(const kernels::Transpose transA, const kernels::Transpose transB, const std::size_t m,
+              const std::size_t n, const std::size_t k, const T alpha, const T *a, const std::size_t lda,
+              const T *b, const std::size_t ldb, const T beta, T *c, const std::size_t ldc) {
+    const kernels::KernelTable<T> &t = table(T());
+    t.gemm(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, gemmWorkspace<T>(t.gemmWorkspaceSize));
+}
+
+}
+
+void kernels::gemv(const Transpose transA, const std::size_t m, const std::size_t n, const float alpha,
+                   const float *a, const std::size_t lda, const float *x, const float beta, float *y) {
+    active().f32.gemv(transA, m, n, alpha, a, lda, x, beta, y);
+}
+
+void kernels::gemv(const Transpose transA, const std::size_t m, const std::size_t n, const double alpha,
+                   const double *a, const std::size_t lda, const double *x, const double beta, double *y) {
+    active().f64.gemv(transA, m, n, alpha, a, lda, x, beta, y);
+}
+
+void kernels::gemm(const Transpose transA, const Transpose transB, const std::size_t m, const std::size_t n,
+                   const std::size_t k, const float alpha, const float *a, const std::size_t lda,
+                   const float *b, const std::size_t ldb, const float beta, float *c, const std::size_t ldc) {
+    gemmImpl(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+void kernels::gemm(const Transpose transA, const Transpose transB, const std::size_t m, const std::size_t n,
+                   const std::size_t k, const double alpha, const double *a, const std::size_t lda,
+                   const double *b, const std::size_t ldb, const double beta, double *c, const std::size_t ldc) {
+    gemmImpl(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+float kernels::dot(const std::size_t n, const float *x, const float *y) {
+    return active().f32.dot(n, x, y);
+}
+
+double kernels::dot(const std::size_t n, const double *x, const double *y) {
+    return active().f64.dot(n, x, y);
+}
+
+void kernels::axpy(const std::size_t n, const float alpha, const float *x, float *y) {
+    active().f32.axpy(n, alpha, x, y);
+}
+
+void kernels::axpy(const std::size_t n, const double alpha, const double *x, double *y) {
+    active().f64.axpy(n, alpha, x, y);
+}
+
+void kernels::momentumAxpy(const std::size_t n, const float alpha, const float *x, const float momentum,
+                           float *delta, float *w) {
+    active().f32.momentumAxpy(n, alpha, x, momentum, delta, w);
+}
+
+void kernels::momentumAxpy(const std::size_t n, const double alpha, const double *x, const double momentum,
+                           double *delta, double *w) {
+    active().f64.momentumAxpy(n, alpha, x, momentum, delta, w);
+}
+
+void kernels::nesterovAxpy(const std::size_t n, const float alpha, const float *x, const float momentum,
+                           float *delta, float *w) {
+    active().f32.nesterovAxpy(n, alpha, x, momentum, delta, w);
+}
+
+void kernels::nesterovAxpy(const std::size_t n, const double alpha, const double *x, const double momentum,
+                           double *delta, double *w) {
+    active().f64.nesterovAxpy(n, alpha, x, momentum, delta, w);
+}
+
+void kernels::adamStep(const std::size_t n, const float scale, const float *x, const float beta1, const float beta2,
+                       const float stepSize, const float epsilon, float *m, float *v, float *w) {
+    active().f32.adamStep(n, scale, x, beta1, beta2, stepSize, epsilon, m, v, w);
+}
+
+void kernels::adamStep(const std::size_t n, const double scale, const double *x, const double beta1,
+                       const double beta2, const double stepSize, const double epsilon, double *m, double *v,
+                       double *w) {
+    active().f64.adamStep(n, scale, x, beta1, beta2, stepSize, epsilon, m, v, w);
+}
+
+void kernels::rmsPropStep(const std::size_t n, const float scale, const float *x, const float decay,
+                          const float stepSize, const float epsilon, float *s, float *w) {
+    active().f32.rmsPropStep(n, scale, x, decay, stepSize, epsilon, s, w);
+}
+
+void kernels::rmsPropStep(const std::size_t n, const double scale, const double *x, const double decay,
+                          const double stepSize, const double epsilon, double *s, double *w) {
+    active().f64.rmsPropStep(n, scale, x, decay, stepSize, epsilon, s, w);
+}
+
+void kernels::biasActivate(const Activation activation, const std::size_t rows, const std::size_t cols,
+                           const float *bias, float *x) {
+    active().f32.biasActivate(activation, rows, cols, bias, x);
+}
+
+void kernels::biasActivate(const Activation activation, const std::size_t rows, const std::size_t cols,
+                           const double *bias, double *x) {
+    active().f64.biasActivate(activation, rows, cols, bias, x);
+}
+
+void kernels::activationGradient(const Activation activation, const std::size_t n, const float *outputs,
+                                 float *gradients) {
+    active().f32.activationGradient(activation, n, outputs, gradients);
+}
+
+void kernels::activationGradient(const Activation activation, const std::size_t n, const double *outputs,
+                                 double *gradients) {
+    active().f64.activationGradient(activation, n, outputs, gradients);
+}
+
+void kernels::gemvU8S8(const std::size_t m, const std::size_t n, const std::int8_t *a, const std::size_t lda,
+                       const std::uint8_t *x, std::int32_t *y) {
+    activeInt8().gemvU8S8(m, n, a, lda, x, y);
+}
+
+const char *kernels::activeIsa() {
+    return active().name;
+}
+
+const char *kernels::activeInt8Isa() {
+    return activeInt8().name;
+}
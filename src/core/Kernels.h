@@ -0,0 +1,92 @@
+//
+// Dense linear algebra kernels used by the layers.
+//
+
+#ifndef XORGATE_NEURALNETWORK_KERNELS_H
+#define XORGATE_NEURALNETWORK_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "Activation.h"
+
+// All matrices are row-major; lda/ldb/ldc are the distances between two rows in elements.
+// The implementation (scalar, SSE2, AVX2 or AVX-512) is picked once at runtime from the CPU's
+// features. Setting the environment variable NN_KERNELS to one of the names returned by
+// activeIsa() forces a specific implementation, e.g. to compare them.
+namespace kernels {
+
+enum class Transpose { No, Yes };
+
+// y = alpha * op(A) * x + beta * y, where A is an m x n matrix; y has m elements (n if transposed).
+// When beta is 0, y is not read.
+void gemv(Transpose transA, std::size_t m, std::size_t n, float alpha, const float *a, std::size_t lda,
+          const float *x, float beta, float *y);
+void gemv(Transpose transA, std::size_t m, std::size_t n, double alpha, const double *a, std::size_t lda,
+          const double *x, double beta, double *y);
+
+// C = alpha * op(A) * op(B) + beta * C, where op(A) is m x k, op(B) is k x n and C is m x n.
+// When beta is 0, C is not read.
+void gemm(Transpose transA, Transpose transB, std::size_t m, std::size_t n, std::size_t k,
+          float alpha, const float *a, std::size_t lda, const float *b, std::size_t ldb,
+          float beta, float *c, std::size_t ldc);
+void gemm(Transpose transA, Transpose transB, std::size_t m, std::size_t n, std::size_t k,
+          double alpha, const double *a, std::size_t lda, const double *b, std::size_t ldb,
+          double beta, double *c, std::size_t ldc);
+
+float dot(std::size_t n, const float *x, const float *y);
+double dot(std::size_t n, const double *x, const double *y);
+
+// y += alpha * x
+void axpy(std::size_t n, float alpha, const float *x, float *y);
+void axpy(std::size_t n, double alpha, const double *x, double *y);
+
+// the momentum step: delta = alpha * x + momentum * delta, then w += delta
+void momentumAxpy(std::size_t n, float alpha, const float *x, float momentum, float *delta, float *w);
+void momentumAxpy(std::size_t n, double alpha, const double *x, double momentum, double *delta, double *w);
+
+// the Nesterov step: delta = alpha * x + momentum * delta, then w += alpha * x + momentum * delta
+void nesterovAxpy(std::size_t n, float alpha, const float *x, float momentum, float *delta, float *w);
+void nesterovAxpy(std::size_t n, double alpha, const double *x, double momentum, double *delta, double *w);
+
+// the Adam step with g = scale * x: m = beta1 * m + (1 - beta1) * g, v = beta2 * v + (1 - beta2) * g^2,
+// then w += stepSize * m / (sqrt(v) + epsilon); the caller folds the bias correction into stepSize
+// and epsilon
+void adamStep(std::size_t n, float scale, const float *x, float beta1, float beta2, float stepSize, float epsilon,
+              float *m, float *v, float *w);
+void adamStep(std::size_t n, double scale, const double *x, double beta1, double beta2, double stepSize,
+              double epsilon, double *m, double *v, double *w);
+
+// the RMSProp step with g = scale * x: s = decay * s + (1 - decay) * g^2, then
+// w += stepSize * g / (sqrt(s) + epsilon)
+void rmsPropStep(std::size_t n, float scale, const float *x, float decay, float stepSize, float epsilon, float *s,
+                 float *w);
+void rmsPropStep(std::size_t n, double scale, const double *x, double decay, double stepSize, double epsilon,
+                 double *s, double *w);
+
+// x[r * cols + c] = f(x[r * cols + c] + bias[c]) for every row; bias may be nullptr.
+// tanh uses a clamped rational approximation with an absolute error below 4e-7 (including float
+// rounding), sigmoid is computed from it as 0.5 + 0.5 * tanh(x / 2).
+void biasActivate(Activation activation, std::size_t rows, std::size_t cols, const float *bias, float *x);
+void biasActivate(Activation activation, std::size_t rows, std::size_t cols, const double *bias, double *x);
+
+// gradients[i] *= f'(x) for every element, with the derivative written in terms of the output
+// value y = f(x) (tanh: 1 - y^2, sigmoid: y * (1 - y), ReLU: y > 0)
+void activationGradient(Activation activation, std::size_t n, const float *outputs, float *gradients);
+void activationGradient(Activation activation, std::size_t n, const double *outputs, double *gradients);
+
+// y = A * x for an m x n int8 matrix A and a uint8 vector x, summed exactly in int32.
+// n must be a multiple of 64 (pad the rows of A with zeros) and every x must be below 128: the
+// AVX2 path adds pairs of products in 16 bits, which only 7-bit values cannot overflow.
+void gemvU8S8(std::size_t m, std::size_t n, const std::int8_t *a, std::size_t lda, const std::uint8_t *x,
+              std::int32_t *y);
+
+// name of the selected implementation: "avx512", "avx2", "sse2" or "scalar"
+const char *activeIsa();
+// name of the implementation used by gemvU8S8: "avx512vnni", "avx2" or "scalar"; never one of
+// a higher instruction set than activeIsa()
+const char *activeInt8Isa();
+
+}
+
+
+#endif //XORGATE_NEURALNETWORK_KERNELS_H
@@ -0,0 +1,115 @@
+//
+// AVX2 + FMA kernels. Built with AVX2/FMA code generation (see CMakeLists.txt); only called
+// after Kernels.cpp has checked that the CPU supports both.
+//
+
+#include "KernelTable.h"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+#include "KernelsImpl.h"
+
+namespace {
+
+struct Avx2Float {
+    using Scalar = float;
+    using Vector = __m256;
+    static constexpr std::size_t width = 8;
+    static constexpr std::size_t mr = 6;
+    static constexpr std::size_t nr = 16;
+
+    static Vector zero() { return _mm256_setzero_ps(); }
+    static Vector set1(const Scalar s) { return _mm256_set1_ps(s); }
+    static Vector load(const Scalar *p) { return _mm256_loadu_ps(p); }
+    static void store(Scalar *p, const Vector v) { _mm256_storeu_ps(p, v); }
+    static Vector add(const Vector a, const Vector b) { return _mm256_add_ps(a, b); }
+    static Vector mul(const Vector a, const Vector b) { return _mm256_mul_ps(a, b); }
+    static Vector sub(const Vector a, const Vector b) { return _mm256_sub_ps(a, b); }
+    static Vector div(const Vector a, const Vector b) { return _mm256_div_ps(a, b); }
+    static Vector sqrt(const Vector a) { return _mm256_sqrt_ps(a); }
+    static Vector min(const Vector a, const Vector b) { return _mm256_min_ps(a, b); }
+    static Vector max(const Vector a, const Vector b) { return _mm256_max_ps(a, b); }
+    static Vector maskPositive(const Vector cond, const Vector v) { return _mm256_and_ps(_mm256_cmp_ps(cond, _mm256_setzero_ps(), _CMP_GT_OQ), v); }
+    static Vector fmadd(const Vector a, const Vector b, const Vector c) { return _mm256_fmadd_ps(a, b, c); }
+    static Scalar reduce(const Vector v) {
+        const __m128 quad = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        const __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+struct Avx2Double {
+    using Scalar = double;
+    using Vector = __m256d;
+    static constexpr std::size_t width = 4;
+    static constexpr std::size_t mr = 6;
+    static constexpr std::size_t nr = 8;
+
+    static Vector zero() { return _mm256_setzero_pd(); }
+    static Vector set1(const Scalar s) { return _mm256_set1_pd(s); }
+    static Vector load(const Scalar *p) { return _mm256_loadu_pd(p); }
+    static void store(Scalar *p, const Vector v) { _mm256_storeu_pd(p, v); }
+    static Vector add(const Vector a, const Vector b) { return _mm256_add_pd(a, b); }
+    static Vector mul(const Vector a, const Vector b) { return _mm256_mul_pd(a, b); }
+    static Vector sub(const Vector a, const Vector b) { return _mm256_sub_pd(a, b); }
+    static Vector div(const Vector a, const Vector b) { return _mm256_div_pd(a, b); }
+    static Vector sqrt(const Vector a) { return _mm256_sqrt_pd(a); }
+    static Vector min(const Vector a, const Vector b) { return _mm256_min_pd(a, b); }
+    static Vector max(const Vector a, const Vector b) { return _mm256_max_pd(a, b); }
+    static Vector maskPositive(const Vector cond, const Vector v) { return _mm256_and_pd(_mm256_cmp_pd(cond, _mm256_setzero_pd(), _CMP_GT_OQ), v); }
+    static Vector fmadd(const Vector a, const Vector b, const Vector c) { return _mm256_fmadd_pd(a, b, c); }
+    static Scalar reduce(const Vector v) {
+        const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+};
+
+// pmaddubsw multiplies the uint8 x with the int8 weights and adds neighbouring products in int16,
+// pmaddwd with ones widens those sums to int32
+void gemvU8S8Avx2(const std::size_t m, const std::size_t n, const std::int8_t *a, const std::size_t lda,
+                  const std::uint8_t *x, std::int32_t *y) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (std::size_t i = 0; i < m; ++i) {
+        const std::int8_t *row = a + i * lda;
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+        for (std::size_t j = 0; j < n; j += 64) {
+            const __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + j));
+            const __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + j + 32));
+            const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + j));
+            const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + j + 32));
+            sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_maddubs_epi16(x0, a0), ones));
+            sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_maddubs_epi16(x1, a1), ones));
+        }
+        const __m256i sum = _mm256_add_epi32(sum0, sum1);
+        __m128i quad = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        quad = _mm_add_epi32(quad, _mm_shuffle_epi32(quad, _MM_SHUFFLE(1, 0, 3, 2)));
+        quad = _mm_add_epi32(quad, _mm_shuffle_epi32(quad, _MM_SHUFFLE(2, 3, 0, 1)));
+        y[i] = _mm_cvtsi128_si32(quad);
+    }
+}
+
+}
+
+bool kernels::avx2Kernels(KernelTables &tables) {
+    tables = {"avx2", BlockedKernels<Avx2Float>::table(), BlockedKernels<Avx2Double>::table()};
+    return true;
+}
+
+bool kernels::avx2Int8Kernel(Int8Kernel &kernel) {
+    kernel = {"avx2", gemvU8S8Avx2};
+    return true;
+}
+
+#else
+
+bool kernels::avx2Kernels(KernelTables &) {
+    return false;
+}
+
+bool kernels::avx2Int8Kernel(Int8Kernel &) {
+    return false;
+}
+
+#endif
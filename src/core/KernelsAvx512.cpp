@@ -0,0 +1,92 @@
+//
+// AVX-512F kernels. Built with AVX-512 code generation (see CMakeLists.txt); only called
+// after Kernels.cpp has checked that the CPU and OS support it.
+//
+
+#include "KernelTable.h"
+
+#if defined(__AVX512F__)
+
+// GCC 12 flags the _mm512_undefined_*() pass-through operands inside its own intrinsics
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+#include "KernelsImpl.h"
+
+namespace {
+
+struct Avx512Float {
+    using Scalar = float;
+    using Vector = __m512;
+    static constexpr std::size_t width = 16;
+    static constexpr std::size_t mr = 8;
+    static constexpr std::size_t nr = 32;
+
+    static Vector zero() { return _mm512_setzero_ps(); }
+    static Vector set1(const Scalar s) { return _mm512_set1_ps(s); }
+    static Vector load(const Scalar *p) { return _mm512_loadu_ps(p); }
+    static void store(Scalar *p, const Vector v) { _mm512_storeu_ps(p, v); }
+    static Vector add(const Vector a, const Vector b) { return _mm512_add_ps(a, b); }
+    static Vector mul(const Vector a, const Vector b) { return _mm512_mul_ps(a, b); }
+    static Vector sub(const Vector a, const Vector b) { return _mm512_sub_ps(a, b); }
+    static Vector div(const Vector a, const Vector b) { return _mm512_div_ps(a, b); }
+    static Vector sqrt(const Vector a) { return _mm512_sqrt_ps(a); }
+    static Vector min(const Vector a, const Vector b) { return _mm512_min_ps(a, b); }
+    static Vector max(const Vector a, const Vector b) { return _mm512_max_ps(a, b); }
+    static Vector maskPositive(const Vector cond, const Vector v) { return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(cond, _mm512_setzero_ps(), _CMP_GT_OQ), v); }
+    static Vector fmadd(const Vector a, const Vector b, const Vector c) { return _mm512_fmadd_ps(a, b, c); }
+    static Scalar reduce(const Vector v) {
+        // fold 512 -> 256 -> 128 bits, then within the 128-bit lane
+        Vector s = _mm512_add_ps(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm512_add_ps(s, _mm512_shuffle_f32x4(s, s, _MM_SHUFFLE(2, 3, 0, 1)));
+        s = _mm512_add_ps(s, _mm512_permute_ps(s, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm512_add_ps(s, _mm512_permute_ps(s, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm512_cvtss_f32(s);
+    }
+};
+
+struct Avx512Double {
+    using Scalar = double;
+    using Vector = __m512d;
+    static constexpr std::size_t width = 8;
+    static constexpr std::size_t mr = 8;
+    static constexpr std::size_t nr = 16;
+
+    static Vector zero() { return _mm512_setzero_pd(); }
+    static Vector set1(const Scalar s) { return _mm512_set1_pd(s); }
+    static Vector load(const Scalar *p) { return _mm512_loadu_pd(p); }
+    static void store(Scalar *p, const Vector v) { _mm512_storeu_pd(p, v); }
+    static Vector add(const Vector a, const Vector b) { return _mm512_add_pd(a, b); }
+    static Vector mul(const Vector a, const Vector b) { return _mm512_mul_pd(a, b); }
+    static Vector sub(const Vector a, const Vector b) { return _mm512_sub_pd(a, b); }
+    static Vector div(const Vector a, const Vector b) { return _mm512_div_pd(a, b); }
+    static Vector sqrt(const Vector a) { return _mm512_sqrt_pd(a); }
+    static Vector min(const Vector a, const Vector b) { return _mm512_min_pd(a, b); }
+    static Vector max(const Vector a, const Vector b) { return _mm512_max_pd(a, b); }
+    static Vector maskPositive(const Vector cond, const Vector v) { return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(cond, _mm512_setzero_pd(), _CMP_GT_OQ), v); }
+    static Vector fmadd(const Vector a, const Vector b, const Vector c) { return _mm512_fmadd_pd(a, b, c); }
+    static Scalar reduce(const Vector v) {
+        Vector s = _mm512_add_pd(v, _mm512_shuffle_f64x2(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm512_add_pd(s, _mm512_shuffle_f64x2(s, s, _MM_SHUFFLE(2, 3, 0, 1)));
+        s = _mm512_add_pd(s, _mm512_permute_pd(s, 0x55));
+        return _mm512_cvtsd_f64(s);
+    }
+};
+
+}
+
+bool kernels::avx512Kernels(KernelTables &tables) {
+    tables = {"avx512", BlockedKernels<Avx512Float>::table(), BlockedKernels<Avx512Double>::table()};
+    return true;
+}
+
+#else
+
+bool kernels::avx512Kernels(KernelTables &) {
+    return false;
+}
+
+#endif
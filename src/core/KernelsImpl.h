@@ -0,0 +1,498 @@
+//
+// Blocked GEMM/GEMV and vector kernels, written once against a small SIMD traits interface
+// and instantiated by every kernel implementation file with its own instruction set.
+// Internal to the kernel implementation files.
+//
+// A traits type provides:
+//   Scalar, Vector, width (scalars per Vector), mr x nr (register tile, nr a multiple of width),
+//   zero(), set1(s), load(p), store(p, v), add(a, b), sub(a, b), mul(a, b), div(a, b),
+//   min(a, b), max(a, b) (b where either is NaN, like minps/maxps), sqrt(a),
+//   fmadd(a, b, c) = a * b + c, reduce(v) = horizontal sum, maskPositive(cond, v) = v where cond > 0, else 0.
+//
+
+#ifndef XORGATE_NEURALNETWORK_KERNELSIMPL_H
+#define XORGATE_NEURALNETWORK_KERNELSIMPL_H
+
+#include <cmath>
+#include <cstddef>
+#include "KernelTable.h"
+
+// Everything here has internal linkage on purpose: each implementation file is compiled with
+// different instruction set flags, and shared (inline/COMDAT) symbols would let the linker pick
+// an AVX-512 copy of a helper for code that runs on any CPU. That includes inline library
+// functions such as std::sqrt(float) or std::size, which unoptimized builds emit out of line, so
+// the scalar code below uses these instead.
+namespace {
+
+float scalarSqrt(const float x) {
+#if defined(__GNUC__)
+    return __builtin_sqrtf(x);
+#else
+    return static_cast<float>(std::sqrt(static_cast<double>(x))); // the double root rounds to the float one
+#endif
+}
+
+double scalarSqrt(const double x) {
+#if defined(__GNUC__)
+    return __builtin_sqrt(x);
+#else
+    return std::sqrt(x);
+#endif
+}
+
+constexpr std::size_t tanhPCount = sizeof(tanhApproximation::p) / sizeof(tanhApproximation::p[0]);
+constexpr std::size_t tanhQCount = sizeof(tanhApproximation::q) / sizeof(tanhApproximation::q[0]);
+
+template<typename Traits>
+struct BlockedKernels {
+    using T = typename Traits::Scalar;
+    using V = typename Traits::Vector;
+
+    static constexpr std::size_t W = Traits::width;
+    static constexpr std::size_t MR = Traits::mr;
+    static constexpr std::size_t NR = Traits::nr;
+    static constexpr std::size_t NV = NR / W;
+
+    // cache blocking: a KC x NR sliver of B stays in L1, an MC x KC block of A in L2,
+    // a KC x NC panel of B in L3
+    static constexpr std::size_t KC = 256;
+    static constexpr std::size_t MC = MR * 16;
+    static constexpr std::size_t NC = NR * 64;
+    static constexpr std::size_t workspaceSize = MC * KC + KC * NC;
+
+    static std::size_t minOf(const std::size_t a, const std::size_t b) { return a < b ? a : b; }
+
+    static T dot(const std::size_t n, const T *x, const T *y) {
+        V acc0 = Traits::zero(), acc1 = Traits::zero(), acc2 = Traits::zero(), acc3 = Traits::zero();
+        std::size_t i = 0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            acc0 = Traits::fmadd(Traits::load(x + i), Traits::load(y + i), acc0);
+            acc1 = Traits::fmadd(Traits::load(x + i + W), Traits::load(y + i + W), acc1);
+            acc2 = Traits::fmadd(Traits::load(x + i + 2 * W), Traits::load(y + i + 2 * W), acc2);
+            acc3 = Traits::fmadd(Traits::load(x + i + 3 * W), Traits::load(y + i + 3 * W), acc3);
+        }
+        for (; i + W <= n; i += W) {
+            acc0 = Traits::fmadd(Traits::load(x + i), Traits::load(y + i), acc0);
+        }
+        T sum = Traits::reduce(Traits::add(Traits::add(acc0, acc1), Traits::add(acc2, acc3)));
+        for (; i < n; ++i) {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    static void axpy(const std::size_t n, const T alpha, const T *x, T *y) {
+        const V va = Traits::set1(alpha);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            Traits::store(y + i, Traits::fmadd(va, Traits::load(x + i), Traits::load(y + i)));
+        }
+        for (; i < n; ++i) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    static void momentumAxpy(const std::size_t n, const T alpha, const T *x, const T momentum, T *delta, T *w) {
+        const V va = Traits::set1(alpha);
+        const V vm = Traits::set1(momentum);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            const V d = Traits::fmadd(va, Traits::load(x + i), Traits::mul(vm, Traits::load(delta + i)));
+            Traits::store(delta + i, d);
+            Traits::store(w + i, Traits::add(Traits::load(w + i), d));
+        }
+        for (; i < n; ++i) {
+            const T d = alpha * x[i] + momentum * delta[i];
+            delta[i] = d;
+            w[i] += d;
+        }
+    }
+
+    static void nesterovAxpy(const std::size_t n, const T alpha, const T *x, const T momentum, T *delta, T *w) {
+        const V va = Traits::set1(alpha);
+        const V vm = Traits::set1(momentum);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            const V step = Traits::mul(va, Traits::load(x + i));
+            const V d = Traits::fmadd(vm, Traits::load(delta + i), step);
+            Traits::store(delta + i, d);
+            Traits::store(w + i, Traits::add(Traits::load(w + i), Traits::fmadd(vm, d, step)));
+        }
+        for (; i < n; ++i) {
+            const T step = alpha * x[i];
+            const T d = step + momentum * delta[i];
+            delta[i] = d;
+            w[i] += step + momentum * d;
+        }
+    }
+
+    // one pass over w, m, v and x: both moments and the weight are updated while in registers
+    static void adamStep(const std::size_t n, const T scale, const T *x, const T beta1, const T beta2,
+                         const T stepSize, const T epsilon, T *m, T *v, T *w) {
+        const V vs = Traits::set1(scale);
+        const V vb1 = Traits::set1(beta1), vc1 = Traits::set1(T(1) - beta1);
+        const V vb2 = Traits::set1(beta2), vc2 = Traits::set1(T(1) - beta2);
+        const V vstep = Traits::set1(stepSize), veps = Traits::set1(epsilon);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            const V g = Traits::mul(vs, Traits::load(x + i));
+            const V mi = Traits::fmadd(vb1, Traits::load(m + i), Traits::mul(vc1, g));
+            const V vi = Traits::fmadd(vb2, Traits::load(v + i), Traits::mul(vc2, Traits::mul(g, g)));
+            Traits::store(m + i, mi);
+            Traits::store(v + i, vi);
+            const V update = Traits::div(Traits::mul(vstep, mi), Traits::add(Traits::sqrt(vi), veps));
+            Traits::store(w + i, Traits::add(Traits::load(w + i), update));
+        }
+        for (; i < n; ++i) {
+            const T g = scale * x[i];
+            m[i] = beta1 * m[i] + (T(1) - beta1) * g;
+            v[i] = beta2 * v[i] + (T(1) - beta2) * g * g;
+            w[i] += stepSize * m[i] / (scalarSqrt(v[i]) + epsilon);
+        }
+    }
+
+    static void rmsPropStep(const std::size_t n, const T scale, const T *x, const T decay, const T stepSize,
+                            const T epsilon, T *s, T *w) {
+        const V vs = Traits::set1(scale);
+        const V vd = Traits::set1(decay), vc = Traits::set1(T(1) - decay);
+        const V vstep = Traits::set1(stepSize), veps = Traits::set1(epsilon);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            const V g = Traits::mul(vs, Traits::load(x + i));
+            const V si = Traits::fmadd(vd, Traits::load(s + i), Traits::mul(vc, Traits::mul(g, g)));
+            Traits::store(s + i, si);
+            const V update = Traits::div(Traits::mul(vstep, g), Traits::add(Traits::sqrt(si), veps));
+            Traits::store(w + i, Traits::add(Traits::load(w + i), update));
+        }
+        for (; i < n; ++i) {
+            const T g = scale * x[i];
+            s[i] = decay * s[i] + (T(1) - decay) * g * g;
+            w[i] += stepSize * g / (scalarSqrt(s[i]) + epsilon);
+        }
+    }
+
+    static void gemv(const kernels::Transpose transA, const std::size_t m, const std::size_t n, const T alpha,
+                     const T *a, const std::size_t lda, const T *x, const T beta, T *y) {
+        if (transA == kernels::Transpose::No) {
+            gemvRows(m, n, alpha, a, lda, x, beta, y);
+        } else {
+            gemvColumns(m, n, alpha, a, lda, x, beta, y);
+        }
+    }
+
+    // y[i] = alpha * dot(row i, x) + beta * y[i]; four rows share every load of x
+    static void gemvRows(const std::size_t m, const std::size_t n, const T alpha, const T *a,
+                         const std::size_t lda, const T *x, const T beta, T *y) {
+        std::size_t r = 0;
+        for (; r + 4 <= m; r += 4) {
+            const T *a0 = a + r * lda;
+            const T *a1 = a0 + lda;
+            const T *a2 = a1 + lda;
+            const T *a3 = a2 + lda;
+            V acc0 = Traits::zero(), acc1 = Traits::zero(), acc2 = Traits::zero(), acc3 = Traits::zero();
+            std::size_t i = 0;
+            for (; i + W <= n; i += W) {
+                const V xv = Traits::load(x + i);
+                acc0 = Traits::fmadd(Traits::load(a0 + i), xv, acc0);
+                acc1 = Traits::fmadd(Traits::load(a1 + i), xv, acc1);
+                acc2 = Traits::fmadd(Traits::load(a2 + i), xv, acc2);
+                acc3 = Traits::fmadd(Traits::load(a3 + i), xv, acc3);
+            }
+            T s0 = Traits::reduce(acc0), s1 = Traits::reduce(acc1), s2 = Traits::reduce(acc2), s3 = Traits::reduce(acc3);
+            for (; i < n; ++i) {
+                s0 += a0[i] * x[i];
+                s1 += a1[i] * x[i];
+                s2 += a2[i] * x[i];
+                s3 += a3[i] * x[i];
+            }
+            storeScaled(y + r, alpha * s0, beta);
+            storeScaled(y + r + 1, alpha * s1, beta);
+            storeScaled(y + r + 2, alpha * s2, beta);
+            storeScaled(y + r + 3, alpha * s3, beta);
+        }
+        for (; r < m; ++r) {
+            storeScaled(y + r, alpha * dot(n, a + r * lda, x), beta);
+        }
+    }
+
+    // y = alpha * A^T * x + beta * y, accumulated as scaled rows of A, four rows per pass over y
+    static void gemvColumns(const std::size_t m, const std::size_t n, const T alpha, const T *a,
+                            const std::size_t lda, const T *x, const T beta, T *y) {
+        scale(n, beta, y);
+        std::size_t r = 0;
+        for (; r + 4 <= m; r += 4) {
+            const T *a0 = a + r * lda;
+            const T *a1 = a0 + lda;
+            const T *a2 = a1 + lda;
+            const T *a3 = a2 + lda;
+            const T x0 = alpha * x[r], x1 = alpha * x[r + 1], x2 = alpha * x[r + 2], x3 = alpha * x[r + 3];
+            const V v0 = Traits::set1(x0), v1 = Traits::set1(x1), v2 = Traits::set1(x2), v3 = Traits::set1(x3);
+            std::size_t j = 0;
+            for (; j + W <= n; j += W) {
+                V acc = Traits::load(y + j);
+                acc = Traits::fmadd(v0, Traits::load(a0 + j), acc);
+                acc = Traits::fmadd(v1, Traits::load(a1 + j), acc);
+                acc = Traits::fmadd(v2, Traits::load(a2 + j), acc);
+                acc = Traits::fmadd(v3, Traits::load(a3 + j), acc);
+                Traits::store(y + j, acc);
+            }
+            for (; j < n; ++j) {
+                y[j] += x0 * a0[j] + x1 * a1[j] + x2 * a2[j] + x3 * a3[j];
+            }
+        }
+        for (; r < m; ++r) {
+            axpy(n, alpha * x[r], a + r * lda, y);
+        }
+    }
+
+    static void storeScaled(T *y, const T value, const T beta) {
+        *y = beta == T(0) ? value : value + beta * *y;
+    }
+
+    static void scale(const std::size_t n, const T beta, T *y) {
+        if (beta == T(1)) {
+            return;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            y[i] = beta == T(0) ? T(0) : beta * y[i];
+        }
+    }
+
+    // copies an mc x kc block of op(A) into row slivers of MR, zero-padding the last one
+    static void packA(const kernels::Transpose transA, const T *a, const std::size_t lda, const std::size_t i0,
+                      const std::size_t p0, const std::size_t mc, const std::size_t kc, T *dst) {
+        for (std::size_t ir = 0; ir < mc; ir += MR) {
+            const std::size_t mr = minOf(MR, mc - ir);
+            for (std::size_t p = 0; p < kc; ++p) {
+                for (std::size_t r = 0; r < MR; ++r) {
+                    const std::size_t i = i0 + ir + r;
+                    const std::size_t k = p0 + p;
+                    dst[p * MR + r] = r >= mr ? T(0)
+                                    : transA == kernels::Transpose::No ? a[i * lda + k] : a[k * lda + i];
+                }
+            }
+            dst += MR * kc;
+        }
+    }
+
+    // copies a kc x nc panel of op(B) into column slivers of NR, zero-padding the last one
+    static void packB(const kernels::Transpose transB, const T *b, const std::size_t ldb, const std::size_t p0,
+                      const std::size_t j0, const std::size_t kc, const std::size_t nc, T *dst) {
+        for (std::size_t jr = 0; jr < nc; jr += NR) {
+            const std::size_t nr = minOf(NR, nc - jr);
+            for (std::size_t p = 0; p < kc; ++p) {
+                const std::size_t k = p0 + p;
+                if (transB == kernels::Transpose::No && nr == NR) {
+                    const T *src = b + k * ldb + j0 + jr;
+                    for (std::size_t c = 0; c < NR; ++c) {
+                        dst[p * NR + c] = src[c];
+                    }
+                    continue;
+                }
+                for (std::size_t c = 0; c < NR; ++c) {
+                    const std::size_t j = j0 + jr + c;
+                    dst[p * NR + c] = c >= nr ? T(0)
+                                    : transB == kernels::Transpose::No ? b[k * ldb + j] : b[j * ldb + k];
+                }
+            }
+            dst += NR * kc;
+        }
+    }
+
+    // MR x NR register tile: C = alpha * (packed A sliver * packed B sliver) + beta * C
+    static void microKernel(const std::size_t kc, const T *pa, const T *pb, const T alpha, const T beta,
+                            T *c, const std::size_t ldc, const std::size_t mr, const std::size_t nr) {
+        V acc[MR][NV];
+        for (std::size_t r = 0; r < MR; ++r) {
+            for (std::size_t v = 0; v < NV; ++v) {
+                acc[r][v] = Traits::zero();
+            }
+        }
+
+        for (std::size_t p = 0; p < kc; ++p) {
+            V bv[NV];
+            for (std::size_t v = 0; v < NV; ++v) {
+                bv[v] = Traits::load(pb + p * NR + v * W);
+            }
+            for (std::size_t r = 0; r < MR; ++r) {
+                const V av = Traits::set1(pa[p * MR + r]);
+                for (std::size_t v = 0; v < NV; ++v) {
+                    acc[r][v] = Traits::fmadd(av, bv[v], acc[r][v]);
+                }
+            }
+        }
+
+        const V valpha = Traits::set1(alpha);
+        if (mr == MR && nr == NR) {
+            const V vbeta = Traits::set1(beta);
+            for (std::size_t r = 0; r < MR; ++r) {
+                for (std::size_t v = 0; v < NV; ++v) {
+                    T *dst = c + r * ldc + v * W;
+                    const V scaled = Traits::mul(valpha, acc[r][v]);
+                    Traits::store(dst, beta == T(0) ? scaled : Traits::fmadd(vbeta, Traits::load(dst), scaled));
+                }
+            }
+            return;
+        }
+
+        // partial tile at the matrix edge
+        T tile[MR * NR];
+        for (std::size_t r = 0; r < MR; ++r) {
+            for (std::size_t v = 0; v < NV; ++v) {
+                Traits::store(tile + r * NR + v * W, Traits::mul(valpha, acc[r][v]));
+            }
+        }
+        for (std::size_t r = 0; r < mr; ++r) {
+            for (std::size_t j = 0; j < nr; ++j) {
+                storeScaled(c + r * ldc + j, tile[r * NR + j], beta);
+            }
+        }
+    }
+
+    static void gemm(const kernels::Transpose transA, const kernels::Transpose transB, const std::size_t m,
+                     const std::size_t n, const std::size_t k, const T alpha, const T *a, const std::size_t lda,
+                     const T *b, const std::size_t ldb, const T beta, T *c, const std::size_t ldc, T *workspace) {
+        if (m == 0 || n == 0) {
+            return;
+        }
+        if (k == 0 || alpha == T(0)) {
+            for (std::size_t i = 0; i < m; ++i) {
+                scale(n, beta, c + i * ldc);
+            }
+            return;
+        }
+
+        T *packedA = workspace;
+        T *packedB = workspace + MC * KC;
+        for (std::size_t jc = 0; jc < n; jc += NC) {
+            const std::size_t nc = minOf(NC, n - jc);
+            for (std::size_t pc = 0; pc < k; pc += KC) {
+                const std::size_t kc = minOf(KC, k - pc);
+                // only the first slice of k applies beta, later ones accumulate
+                const T blockBeta = pc == 0 ? beta : T(1);
+                packB(transB, b, ldb, pc, jc, kc, nc, packedB);
+
+                for (std::size_t ic = 0; ic < m; ic += MC) {
+                    const std::size_t mc = minOf(MC, m - ic);
+                    packA(transA, a, lda, ic, pc, mc, kc, packedA);
+
+                    for (std::size_t jr = 0; jr < nc; jr += NR) {
+                        for (std::size_t ir = 0; ir < mc; ir += MR) {
+                            microKernel(kc, packedA + ir * kc, packedB + jr * kc, alpha, blockBeta,
+                                        c + (ic + ir) * ldc + jc + jr, ldc,
+                                        minOf(MR, mc - ir), minOf(NR, nc - jr));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // tanh as a clamped rational function x * P(x^2) / Q(x^2), see tanhApproximation; x is the
+    // second operand of min/max so a NaN passes through, as it does in activate()
+    static V tanhVector(V x) {
+        const V limit = Traits::set1(T(tanhApproximation::limit));
+        x = Traits::max(Traits::sub(Traits::zero(), limit), Traits::min(limit, x));
+        const V x2 = Traits::mul(x, x);
+
+        V p = Traits::set1(T(tanhApproximation::p[0]));
+        for (std::size_t k = 1; k < tanhPCount; ++k) {
+            p = Traits::fmadd(x2, p, Traits::set1(T(tanhApproximation::p[k])));
+        }
+        p = Traits::mul(x, p);
+
+        V q = Traits::set1(T(tanhApproximation::q[0]));
+        for (std::size_t k = 1; k < tanhQCount; ++k) {
+            q = Traits::fmadd(x2, q, Traits::set1(T(tanhApproximation::q[k])));
+        }
+        return Traits::div(p, q);
+    }
+
+    static V activateVector(const Activation activation, const V x) {
+        switch (activation) {
+            case Activation::Tanh:
+                return tanhVector(x);
+            case Activation::Sigmoid: {
+                const V half = Traits::set1(T(0.5));
+                return Traits::fmadd(half, tanhVector(Traits::mul(half, x)), half);
+            }
+            case Activation::ReLU:
+                return Traits::max(Traits::zero(), x);
+            case Activation::Linear:
+                break;
+        }
+        return x;
+    }
+
+    static V derivativeVector(const Activation activation, const V y, const V gradient) {
+        const V one = Traits::set1(T(1));
+        switch (activation) {
+            case Activation::Tanh:
+                return Traits::mul(gradient, Traits::sub(one, Traits::mul(y, y)));
+            case Activation::Sigmoid:
+                return Traits::mul(gradient, Traits::mul(y, Traits::sub(one, y)));
+            case Activation::ReLU:
+                return Traits::maskPositive(y, gradient);
+            case Activation::Linear:
+                break;
+        }
+        return gradient;
+    }
+
+    static void biasActivate(const Activation activation, const std::size_t rows, const std::size_t cols,
+                             const T *bias, T *x) {
+        for (std::size_t r = 0; r < rows; ++r) {
+            T *row = x + r * cols;
+            std::size_t c = 0;
+            for (; c + W <= cols; c += W) {
+                V v = Traits::load(row + c);
+                if (bias) {
+                    v = Traits::add(v, Traits::load(bias + c));
+                }
+                Traits::store(row + c, activateVector(activation, v));
+            }
+            if (c < cols) {
+                // the tail goes through the same vector code so every element gets identical rounding
+                T tail[W] = {};
+                for (std::size_t j = c; j < cols; ++j) {
+                    tail[j - c] = bias ? row[j] + bias[j] : row[j];
+                }
+                Traits::store(tail, activateVector(activation, Traits::load(tail)));
+                for (std::size_t j = c; j < cols; ++j) {
+                    row[j] = tail[j - c];
+                }
+            }
+        }
+    }
+
+    static void activationGradient(const Activation activation, const std::size_t n, const T *outputs,
+                                   T *gradients) {
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            Traits::store(gradients + i, derivativeVector(activation, Traits::load(outputs + i),
+                                                          Traits::load(gradients + i)));
+        }
+        if (i < n) {
+            T y[W] = {};
+            T g[W] = {};
+            for (std::size_t j = i; j < n; ++j) {
+                y[j - i] = outputs[j];
+                g[j - i] = gradients[j];
+            }
+            Traits::store(g, derivativeVector(activation, Traits::load(y), Traits::load(g)));
+            for (std::size_t j = i; j < n; ++j) {
+                gradients[j] = g[j - i];
+            }
+        }
+    }
+
+    static kernels::KernelTable<T> table() {
+        return {workspaceSize, &gemv, &gemm, &dot, &axpy, &momentumAxpy, &nesterovAxpy, &adamStep, &rmsPropStep,
+                &biasActivate, &activationGradient};
+    }
+};
+
+}
+
+
+#endif //XORGATE_NEURALNETWORK_KERNELSIMPL_H
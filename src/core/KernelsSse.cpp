@@ -0,0 +1,76 @@
+//
+// SSE2 kernels: the baseline on every x86-64 CPU.
+//
+
+#include "KernelTable.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+#include "KernelsImpl.h"
+
+namespace {
+
+struct SseFloat {
+    using Scalar = float;
+    using Vector = __m128;
+    static constexpr std::size_t width = 4;
+    static constexpr std::size_t mr = 4;
+    static constexpr std::size_t nr = 8;
+
+    static Vector zero() { return _mm_setzero_ps(); }
+    static Vector set1(const Scalar s) { return _mm_set1_ps(s); }
+    static Vector load(const Scalar *p) { return _mm_loadu_ps(p); }
+    static void store(Scalar *p, const Vector v) { _mm_storeu_ps(p, v); }
+    static Vector add(const Vector a, const Vector b) { return _mm_add_ps(a, b); }
+    static Vector mul(const Vector a, const Vector b) { return _mm_mul_ps(a, b); }
+    static Vector sub(const Vector a, const Vector b) { return _mm_sub_ps(a, b); }
+    static Vector div(const Vector a, const Vector b) { return _mm_div_ps(a, b); }
+    static Vector sqrt(const Vector a) { return _mm_sqrt_ps(a); }
+    static Vector min(const Vector a, const Vector b) { return _mm_min_ps(a, b); }
+    static Vector max(const Vector a, const Vector b) { return _mm_max_ps(a, b); }
+    static Vector maskPositive(const Vector cond, const Vector v) { return _mm_and_ps(_mm_cmpgt_ps(cond, _mm_setzero_ps()), v); }
+    static Vector fmadd(const Vector a, const Vector b, const Vector c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static Scalar reduce(const Vector v) {
+        const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+struct SseDouble {
+    using Scalar = double;
+    using Vector = __m128d;
+    static constexpr std::size_t width = 2;
+    static constexpr std::size_t mr = 4;
+    static constexpr std::size_t nr = 4;
+
+    static Vector zero() { return _mm_setzero_pd(); }
+    static Vector set1(const Scalar s) { return _mm_set1_pd(s); }
+    static Vector load(const Scalar *p) { return _mm_loadu_pd(p); }
+    static void store(Scalar *p, const Vector v) { _mm_storeu_pd(p, v); }
+    static Vector add(const Vector a, const Vector b) { return _mm_add_pd(a, b); }
+    static Vector mul(const Vector a, const Vector b) { return _mm_mul_pd(a, b); }
+    static Vector sub(const Vector a, const Vector b) { return _mm_sub_pd(a, b); }
+    static Vector div(const Vector a, const Vector b) { return _mm_div_pd(a, b); }
+    static Vector sqrt(const Vector a) { return _mm_sqrt_pd(a); }
+    static Vector min(const Vector a, const Vector b) { return _mm_min_pd(a, b); }
+    static Vector max(const Vector a, const Vector b) { return _mm_max_pd(a, b); }
+    static Vector maskPositive(const Vector cond, const Vector v) { return _mm_and_pd(_mm_cmpgt_pd(cond, _mm_setzero_pd()), v); }
+    static Vector fmadd(const Vector a, const Vector b, const Vector c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static Scalar reduce(const Vector v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+};
+
+}
+
+bool kernels::sseKernels(KernelTables &tables) {
+    tables = {"sse2", BlockedKernels<SseFloat>::table(), BlockedKernels<SseDouble>::table()};
+    return true;
+}
+
+#else
+
+bool kernels::sseKernels(KernelTables &) {
+    return false;
+}
+
+#endif
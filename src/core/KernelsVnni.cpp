@@ -0,0 +1,47 @@
+//
+// AVX-512 VNNI int8 kernel. Built with AVX-512BW/VNNI code generation (see CMakeLists.txt); only
+// called after Kernels.cpp has checked that the CPU supports both.
+//
+
+#include "KernelTable.h"
+
+#if defined(__AVX512VNNI__) || (defined(_MSC_VER) && defined(__AVX512F__))
+
+#include <immintrin.h>
+
+namespace {
+
+// vpdpbusd multiplies 64 uint8/int8 pairs and adds each group of four straight into int32
+void gemvU8S8Vnni(const std::size_t m, const std::size_t n, const std::int8_t *a, const std::size_t lda,
+                  const std::uint8_t *x, std::int32_t *y) {
+    for (std::size_t i = 0; i < m; ++i) {
+        const std::int8_t *row = a + i * lda;
+        __m512i sum = _mm512_setzero_si512();
+        for (std::size_t j = 0; j < n; j += 64) {
+            sum = _mm512_dpbusd_epi32(sum, _mm512_loadu_si512(x + j), _mm512_loadu_si512(row + j));
+        }
+        // once per row, so a plain sum of the lanes is cheap enough
+        alignas(64) std::int32_t lanes[16];
+        _mm512_store_si512(lanes, sum);
+        std::int32_t total = 0;
+        for (const std::int32_t lane : lanes) {
+            total += lane;
+        }
+        y[i] = total;
+    }
+}
+
+}
+
+bool kernels::vnniInt8Kernel(Int8Kernel &kernel) {
+    kernel = {"avx512vnni", gemvU8S8Vnni};
+    return true;
+}
+
+#else
+
+bool kernels::vnniInt8Kernel(Int8Kernel &) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,75 @@
+//
+// Learning rates that change from epoch to epoch.
+//
+
+#include "LearningRateSchedule.h"
+#include <cmath>
+#include <numbers>
+
+namespace {
+
+constexpr ScheduleType ScheduleTypes[] = {ScheduleType::Constant, ScheduleType::Step, ScheduleType::Cosine};
+
+}
+
+const char *scheduleName(const ScheduleType type) {
+    switch (type) {
+        case ScheduleType::Constant: return "constant";
+        case ScheduleType::Step: return "step";
+        case ScheduleType::Cosine: return "cosine";
+    }
+    return "constant";
+}
+
+bool parseSchedule(const std::string &name, ScheduleType &type) {
+    for (const ScheduleType candidate : ScheduleTypes) {
+        if (name == scheduleName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+LearningRateSchedule LearningRateSchedule::constant(const std::size_t warmupEpochs) {
+    LearningRateSchedule schedule;
+    schedule.warmupEpochs = warmupEpochs;
+    return schedule;
+}
+
+LearningRateSchedule LearningRateSchedule::step(const std::size_t stepEpochs, const double stepFactor,
+                                                const std::size_t warmupEpochs) {
+    LearningRateSchedule schedule;
+    schedule.type = ScheduleType::Step;
+    schedule.warmupEpochs = warmupEpochs;
+    schedule.stepEpochs = stepEpochs;
+    schedule.stepFactor = stepFactor;
+    return schedule;
+}
+
+LearningRateSchedule LearningRateSchedule::cosine(const double minFactor, const std::size_t warmupEpochs) {
+    LearningRateSchedule schedule;
+    schedule.type = ScheduleType::Cosine;
+    schedule.warmupEpochs = warmupEpochs;
+    schedule.minFactor = minFactor;
+    return schedule;
+}
+
+double LearningRateSchedule::factor(const std::size_t epoch, const std::size_t epochCount) const {
+    if (epoch < warmupEpochs) {
+        return static_cast<double>(epoch + 1) / static_cast<double>(warmupEpochs);
+    }
+    const std::size_t scheduled = epoch - warmupEpochs;
+    switch (type) {
+        case ScheduleType::Constant:
+            break;
+        case ScheduleType::Step:
+            return stepEpochs == 0 ? 1.0 : std::pow(stepFactor, static_cast<double>(scheduled / stepEpochs));
+        case ScheduleType::Cosine: {
+            const std::size_t length = epochCount > warmupEpochs ? epochCount - warmupEpochs : 1;
+            const double progress = static_cast<double>(scheduled) / static_cast<double>(length);
+            return minFactor + (1.0 - minFactor) * 0.5 * (1.0 + std::cos(std::numbers::pi * progress));
+        }
+    }
+    return 1.0;
+}
@@ -0,0 +1,44 @@
+//
+// Learning rates that change from epoch to epoch.
+//
+
+#ifndef XORGATE_NEURALNETWORK_LEARNINGRATESCHEDULE_H
+#define XORGATE_NEURALNETWORK_LEARNINGRATESCHEDULE_H
+
+#include <cstddef>
+#include <string>
+
+enum class ScheduleType {
+    Constant, // the optimizer's learning rate throughout
+    Step,     // multiplied by stepFactor every stepEpochs epochs
+    Cosine    // follows half a cosine from the full rate down to minFactor times it
+};
+
+// lower-case name ("constant", "step", "cosine"), used on the command line
+const char *scheduleName(ScheduleType type);
+
+// parses a name produced by scheduleName; returns false for unknown names
+bool parseSchedule(const std::string &name, ScheduleType &type);
+
+// A LearningRateSchedule scales the optimizer's learning rate once per epoch. An optional warmup
+// ramps it up linearly over the first warmupEpochs epochs (1/warmupEpochs of the rate in the
+// first one), which keeps Adam and large batches from taking wild first steps; the schedule
+// itself then runs over the remaining epochs. Apply it with Net::setOptimizer, which keeps the
+// optimizer's state when only the learning rate changes.
+struct LearningRateSchedule {
+    ScheduleType type = ScheduleType::Constant;
+    std::size_t warmupEpochs = 0;
+    std::size_t stepEpochs = 10; // Step: epochs between two reductions
+    double stepFactor = 0.1;     // Step: multiplier per reduction
+    double minFactor = 0.0;      // Cosine: multiplier reached at the end
+
+    static LearningRateSchedule constant(std::size_t warmupEpochs = 0);
+    static LearningRateSchedule step(std::size_t stepEpochs, double stepFactor = 0.1, std::size_t warmupEpochs = 0);
+    static LearningRateSchedule cosine(double minFactor = 0.0, std::size_t warmupEpochs = 0);
+
+    // multiplier of the learning rate in epoch (counting from 0) of epochCount
+    [[nodiscard]] double factor(std::size_t epoch, std::size_t epochCount) const;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_LEARNINGRATESCHEDULE_H
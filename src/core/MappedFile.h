@@ -0,0 +1,35 @@
+//
+// Read-only memory mapping of a whole file.
+//
+
+#ifndef XORGATE_NEURALNETWORK_MAPPEDFILE_H
+#define XORGATE_NEURALNETWORK_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// The file's pages are loaded lazily by the OS and shared with the page cache, so opening a
+// large file is cheap and reading it does not copy it into the process.
+class MappedFile {
+public:
+    // throws std::runtime_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::string &filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] const unsigned char *data() const { return m_data; }
+    [[nodiscard]] std::size_t size() const { return m_size; }
+
+private:
+    const unsigned char *m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
+
+
+#endif //XORGATE_NEURALNETWORK_MAPPEDFILE_H
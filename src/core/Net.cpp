@@ -3,65 +3,344 @@
 //
 
 #include "Net.h"
+#include "CheckedSize.h"
 #include "Neuron.h"
+#include "Connection.h"
+#include "Kernels.h"
+#include "MappedFile.h"
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <type_traits>
 
-Net::Net(const vector<unsigned int> &topology)
+namespace {
+
+constexpr char ModelMagic[8] = {'N', 'N', 'M', 'O', 'D', 'E', 'L', '\0'};
+constexpr std::uint32_t ModelVersion = 2;
+constexpr std::uint32_t OptimizerStateFlag = 1;
+constexpr std::size_t ModelHeaderSize = 32;
+constexpr std::size_t BlockAlignment = 64;
+
+// parameters are copied straight out of the mapping, so the host has to share the file's byte order
+static_assert(std::endian::native == std::endian::little,
+              "the model format is little-endian; big-endian hosts are not supported");
+
+// activation codes are part of the file format and independent of the enum's values
+std::uint32_t activationCode(const Activation activation) {
+    switch (activation) {
+        case Activation::Tanh: return 0;
+        case Activation::Sigmoid: return 1;
+        case Activation::ReLU: return 2;
+        case Activation::Linear: return 3;
+    }
+    return 0;
+}
+
+bool activationFromCode(const std::uint32_t code, Activation &activation) {
+    constexpr Activation Activations[] = {Activation::Tanh, Activation::Sigmoid, Activation::ReLU, Activation::Linear};
+    if (code >= std::size(Activations)) {
+        return false;
+    }
+    activation = Activations[code];
+    return true;
+}
+
+// optimizer codes, like the activation codes
+std::uint32_t optimizerCode(const OptimizerType type) {
+    switch (type) {
+        case OptimizerType::Momentum: return 0;
+        case OptimizerType::Nesterov: return 1;
+        case OptimizerType::Adam: return 2;
+        case OptimizerType::RMSProp: return 3;
+    }
+    return 0;
+}
+
+bool optimizerFromCode(const std::uint32_t code, OptimizerType &type) {
+    constexpr OptimizerType Types[] = {OptimizerType::Momentum, OptimizerType::Nesterov, OptimizerType::Adam,
+                                       OptimizerType::RMSProp};
+    if (code >= std::size(Types)) {
+        return false;
+    }
+    type = Types[code];
+    return true;
+}
+
+// the optimizer fields follow the topology and activations at this offset
+std::size_t optimizerFieldsOffset(const std::size_t layerCount) {
+    const std::size_t end = ModelHeaderSize + (2 * layerCount - 1) * sizeof(std::uint32_t);
+    return (end + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t) * sizeof(std::uint64_t);
+}
+constexpr std::size_t OptimizerFieldsSize = 4 * sizeof(double) + sizeof(std::uint64_t);
+
+std::size_t alignUp(const std::size_t offset) {
+    return (offset + BlockAlignment - 1) / BlockAlignment * BlockAlignment;
+}
+
+// floating-point operations of one optimizer step on one parameter, for the profile
+std::uint64_t updateFlops(const OptimizerType type) {
+    switch (type) {
+        case OptimizerType::Momentum: return 4;
+        case OptimizerType::Nesterov: return 6;
+        case OptimizerType::Adam: return 12;
+        case OptimizerType::RMSProp: return 9;
+    }
+    return 4;
+}
+
+template<typename T>
+T readField(const unsigned char *data, const std::size_t offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+template<typename T>
+void writeField(std::ofstream &out, const T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// parameters are always stored as float64, whatever the net computes in
+void writeArray(std::ofstream &out, std::size_t &offset, const std::span<const double> values) {
+    static constexpr char Zeros[BlockAlignment] = {};
+    const std::size_t start = alignUp(offset);
+    out.write(Zeros, static_cast<std::streamsize>(start - offset));
+    out.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(double)));
+    offset = start + values.size() * sizeof(double);
+}
+
+void writeArray(std::ofstream &out, std::size_t &offset, const std::span<const float> values) {
+    writeArray(out, offset, vector<double>(values.begin(), values.end()));
+}
+
+}
+
+template<typename T>
+BasicNet<T>::BasicNet(const vector<unsigned int> &topology, const vector<Activation> &activations)
+    : BasicNet(topology, activations, true)
+{
+}
+
+template<typename T>
+BasicNet<T>::BasicNet(const vector<unsigned int> &topology, const vector<Activation> &activations, const bool randomWeights)
     : m_error(0.0)
     , m_recentAverageError(0.0)
     , m_recentAverageSmoothingFactor(100.0)
 {
-    const std::size_t numLayers = topology.size();
-    for (std::size_t layerNum = 0; layerNum < numLayers; ++layerNum) {
-        m_layers.push_back(Layer());
-        const unsigned numOutputs =
-            layerNum == topology.size() - 1 ? 0 : topology[layerNum + 1];
+    assert(topology.size() >= 2);
+    assert(activations.empty() || activations.size() == topology.size() - 1);
+
+    m_layers.reserve(topology.size() - 1);
+    for (std::size_t layerNum = 1; layerNum < topology.size(); ++layerNum) {
+        const Activation activation = activations.empty() ? Activation::Tanh : activations[layerNum - 1];
+        m_layers.emplace_back(topology[layerNum - 1], topology[layerNum], activation);
+    }
+    placeArrays(topology[0], false);
+    initProfiler();
+
+    if (!randomWeights) {
+        return;
+    }
+
+    // Draw the random weights source neuron by source neuron (bias last), the order in which
+    // the neurons used to create their connections, so seeded runs start from the same weights.
+    for (DenseLayer<T> &layer : m_layers) {
+        for (std::size_t input = 0; input <= layer.getInputCount(); ++input) {
+            for (std::size_t output = 0; output < layer.getOutputCount(); ++output) {
+                if (input == layer.getInputCount()) {
+                    layer.setBias(output, Connection::randomWeight());
+                } else {
+                    layer.setWeight(output, input, Connection::randomWeight());
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+BasicNet<T>::BasicNet(const BasicNet &other)
+    : m_inputVals(other.m_inputVals)
+    , m_layers(other.m_layers)
+    , m_error(other.m_error)
+    , m_recentAverageError(other.m_recentAverageError)
+    , m_recentAverageSmoothingFactor(other.m_recentAverageSmoothingFactor)
+    , m_optimizer(other.m_optimizer)
+    , m_step(other.m_step)
+{
+    // the copied spans still point into other's arena; placing them copies the values over
+    placeArrays(other.getInputCount(), other.hasMasterWeights());
+    initProfiler();
+}
+
+template<typename T>
+BasicNet<T> &BasicNet<T>::operator=(const BasicNet &other) {
+    if (this != &other) {
+        // the counters describe the work done on this net, e.g. when early stopping restores a copy
+        const vector<unsigned> topology = getTopology();
+        Profiler profiler = std::move(m_profiler);
+        *this = BasicNet(other);
+        if (topology == getTopology()) {
+            m_profiler = std::move(profiler);
+        }
+    }
+    return *this;
+}
+
+template<typename T>
+void BasicNet<T>::placeArrays(const size_t inputCount, const bool masterWeights) {
+    size_t bytes = Arena::bytesFor<T>(inputCount);
+    for (const DenseLayer<T> &layer : m_layers) {
+        bytes += DenseLayer<T>::arenaBytes(layer.getInputCount(), layer.getOutputCount(), m_optimizer.stateCount(),
+                                           masterWeights);
+    }
+
+    // the old arena stays alive until everything has been copied out of it
+    Arena arena(bytes);
+    const std::span<T> inputVals = arena.allocate<T>(inputCount);
+    std::copy(m_inputVals.begin(), m_inputVals.end(), inputVals.begin());
+    m_inputVals = inputVals;
+    for (DenseLayer<T> &layer : m_layers) {
+        layer.place(arena, m_optimizer.stateCount(), masterWeights);
+    }
+    m_arena = std::move(arena);
+}
+
+template<typename T>
+void BasicNet<T>::placeWorkspace(Workspace &workspace, const size_t batchSize, const bool training) const {
+    const size_t numLayers = m_layers.size();
+    const bool convertInputs = training && !std::is_same_v<T, float>;
+
+    size_t bytes = convertInputs ? Arena::bytesFor<T>(batchSize * m_inputVals.size()) : 0;
+    for (const DenseLayer<T> &layer : m_layers) {
+        bytes += Arena::bytesFor<T>(batchSize * layer.getOutputCount());
+        if (training) {
+            bytes += Arena::bytesFor<T>(batchSize * layer.getOutputCount())
+                     + Arena::bytesFor<T>(layer.getOutputCount() * layer.getInputCount())
+                     + Arena::bytesFor<T>(layer.getOutputCount());
+        }
+    }
+    if (training) {
+        bytes += Arena::bytesFor<double>(batchSize);
+    }
+    if (bytes > workspace.arena.capacity()) {
+        workspace.arena = Arena(bytes);
+    }
+
+    // the buffers are laid out again for every batch, which only bumps an offset
+    Arena &arena = workspace.arena;
+    arena.reset();
+    workspace.inputs = convertInputs ? arena.allocate<T>(batchSize * m_inputVals.size()) : std::span<T>();
+    workspace.outputs.resize(numLayers);
+    for (size_t l = 0; l < numLayers; ++l) {
+        workspace.outputs[l] = arena.allocate<T>(batchSize * m_layers[l].getOutputCount());
+    }
+    if (!training) {
+        return;
+    }
+    workspace.gradients.resize(numLayers);
+    workspace.weightGradients.resize(numLayers);
+    workspace.biasGradients.resize(numLayers);
+    for (size_t l = 0; l < numLayers; ++l) {
+        const DenseLayer<T> &layer = m_layers[l];
+        workspace.gradients[l] = arena.allocate<T>(batchSize * layer.getOutputCount());
+        workspace.weightGradients[l] = arena.allocate<T>(layer.getOutputCount() * layer.getInputCount());
+        workspace.biasGradients[l] = arena.allocate<T>(layer.getOutputCount());
+    }
+    workspace.sampleErrors = arena.allocate<double>(batchSize);
+}
 
-        for (unsigned neuronNum = 0; neuronNum <= topology[layerNum]; ++neuronNum) {
-            m_layers.back().push_back(Neuron(numOutputs, neuronNum));
-            //cout << "Make a neuron in layer: " << layerNum << ". It has " << numOutputs << " outputs." << endl;
+template<typename T>
+void BasicNet<T>::initProfiler() {
+    vector<std::array<size_t, 2>> shapes;
+    shapes.reserve(m_layers.size());
+    for (const DenseLayer<T> &layer : m_layers) {
+        shapes.push_back({layer.getInputCount(), layer.getOutputCount()});
+    }
+    m_profiler.setLayers(shapes);
+}
+
+template<typename T>
+void BasicNet<T>::profile(const size_t layer, const ProfilePhase phase, const size_t samples, const std::uint64_t start,
+                          const bool weightGradients) const {
+    if constexpr (profilingEnabled) {
+        const std::uint64_t end = Profiler::now();
+        const DenseLayer<T> &dense = m_layers[layer];
+        const std::uint64_t n = samples;
+        const std::uint64_t inputs = dense.getInputCount();
+        const std::uint64_t outputs = dense.getOutputCount();
+        const std::uint64_t parameters = (inputs + 1) * outputs;
+        std::uint64_t flops = 0;
+        std::uint64_t values = 0; // scalars of type T read or written
+
+        switch (phase) {
+            case ProfilePhase::Forward:
+                // a multiply-add per weight, the bias and the activation
+                flops = n * (2 * inputs * outputs + 2 * outputs);
+                values = parameters + n * (inputs + outputs);
+                break;
+            case ProfilePhase::Backward: {
+                // hidden layers pull their gradients back through the next layer's weights
+                const std::uint64_t next = layer + 1 < m_layers.size() ? m_layers[layer + 1].getOutputCount() : 0;
+                flops = n * (next > 0 ? 2 * next * outputs + 2 * outputs : 3 * outputs);
+                values = next * outputs + n * (next + 2 * outputs);
+                break;
+            }
+            case ProfilePhase::Update:
+                // read the gradient, read and write the parameter and every state array
+                flops = parameters * updateFlops(m_optimizer.type);
+                values = parameters * (3 + 2 * m_optimizer.stateCount());
+                break;
         }
-        // Force the bias node output value to 1.0:
-        m_layers.back().back().setOutputVal(1.0);
+        if (weightGradients) {
+            // the outer product of the layer's gradients and inputs
+            flops += n * 2 * parameters;
+            values += parameters + n * inputs;
+        }
+        m_profiler.record(layer, phase, n, flops, values * sizeof(T), start, end);
     }
 }
 
 // feedForward loops through the net and calculates the output values for each neuron
-void Net::feedForward(const vector<double> &inputValues) {
-    assert(inputValues.size() == m_layers[0].size() - 1);
+template<typename T>
+void BasicNet<T>::feedForward(const vector<double> &inputValues) {
+    assert(inputValues.size() == m_inputVals.size());
 
     // assing (latch) the input values into the input neurons
     for (std::size_t input = 0; input < inputValues.size(); ++input) {
-        m_layers[0][input].setOutputVal(inputValues[input]);
+        m_inputVals[input] = static_cast<T>(inputValues[input]);
     }
 
-    // note that we are starting at the second layer, because the first layer is the input layer
-    for (std::size_t layerNum = 1; layerNum < m_layers.size(); ++layerNum) {
-        Layer &prevLayer = m_layers[layerNum - 1];
-        // Skip bias neuron: prevLayer neurons have m_outputWeights only for non-bias
-        // targets; bias output stays 1.0 from constructor
-        for (std::size_t neurons = 0; neurons < m_layers[layerNum].size() - 1; ++neurons) {
-            m_layers[layerNum][neurons].feedForward(prevLayer);
-        }
+    // every dense layer reads the outputs of the layer before it; the bias is part of the layer
+    std::span<const T> prevOutputs = m_inputVals;
+    for (size_t l = 0; l < m_layers.size(); ++l) {
+        const std::uint64_t start = Profiler::now();
+        m_layers[l].feedForward(prevOutputs);
+        profile(l, ProfilePhase::Forward, 1, start);
+        prevOutputs = m_layers[l].getOutputs();
     }
 }
 
 // BackPropagate is used to calculate the error and adjust the weights; Basically, it is the process of training.
-void Net::backPropagate(const vector<double> &targetValues) {
+template<typename T>
+void BasicNet<T>::backPropagate(const vector<double> &targetValues) {
 
-    Layer &outputLayer = m_layers.back();
+    DenseLayer<T> &outputLayer = m_layers.back();
+    const std::span<const T> outputVals = outputLayer.getOutputs();
     m_error = 0.0;
 
-    for (std::size_t neuron = 0; neuron < outputLayer.size() - 1; ++neuron) {
-        const double delta = targetValues[neuron] - outputLayer[neuron].getOutputVal(); // delta is the difference between the target value and the actual value
+    for (std::size_t neuron = 0; neuron < outputVals.size(); ++neuron) {
+        const double delta = targetValues[neuron] - static_cast<double>(outputVals[neuron]); // delta is the difference between the target value and the actual value
         m_error += delta * delta;
     }
 
     // calculate the average error squared
-    m_error /= static_cast<double>(outputLayer.size() - 1);
+    m_error /= static_cast<double>(outputVals.size());
     m_error = sqrt(m_error); // RMS(Root Mean Square Error)
 
     // implement a recent average measurement
@@ -69,55 +348,388 @@ void Net::backPropagate(const vector<double> &targetValues) {
                            (m_recentAverageSmoothingFactor + 1.0);
 
     // Calculate output layer gradients
-    for (std::size_t neuron = 0; neuron < outputLayer.size() - 1; ++neuron) {
-        // TODO: Move this to the upper loop
-        outputLayer[neuron].calculateOutputGradients(targetValues[neuron]);
+    std::uint64_t start = Profiler::now();
+    outputLayer.calculateOutputGradients(targetValues);
+    profile(m_layers.size() - 1, ProfilePhase::Backward, 1, start);
+
+    // Calculate gradients on hidden layers, from the last hidden layer backwards
+    for (std::size_t layerNum = m_layers.size() - 1; layerNum > 0; --layerNum) {
+        start = Profiler::now();
+        m_layers[layerNum - 1].calculateHiddenGradients(m_layers[layerNum]);
+        profile(layerNum - 1, ProfilePhase::Backward, 1, start);
+    }
+
+    const std::uint64_t step = ++m_step;
+    for (std::size_t layerNum = m_layers.size(); layerNum > 0; --layerNum) {
+        const std::span<const T> prevOutputs =
+            layerNum == 1 ? std::span<const T>(m_inputVals) : m_layers[layerNum - 2].getOutputs();
+        start = Profiler::now();
+        m_layers[layerNum - 1].updateWeights(prevOutputs, m_optimizer, step);
+        profile(layerNum - 1, ProfilePhase::Update, 1, start, true);
     }
+}
 
+template<typename T>
+void BasicNet<T>::trainBatch(const float *inputs, const float *targets, const size_t batchSize) {
+    if (batchSize == 0) {
+        return;
+    }
+    computeGradients(inputs, targets, batchSize, T(1) / static_cast<T>(batchSize), m_workspace);
+    recordErrors(m_workspace.sampleErrors);
+    applyGradients(m_workspace);
+}
 
-    // Calculate gradients on hidden layers
-    // TODO: Check if the loop starts at the output layer or the first hidden layer;
-    for (std::size_t layerNum = m_layers.size() - 2; layerNum > 0; --layerNum) {
-        Layer &hiddenLayer = m_layers[layerNum];
-        Layer &nextLayer = m_layers[layerNum + 1];
+template<typename T>
+void BasicNet<T>::computeGradients(const float *inputs, const float *targets, const size_t batchSize,
+                           const T scale, Workspace &workspace) const {
+    const size_t numLayers = m_layers.size();
+    placeWorkspace(workspace, batchSize, true);
 
-        for (auto & neuron : hiddenLayer) {
-            neuron.calculateHiddenGradients(nextLayer);
+    // float nets read the batch in place, double nets need a converted copy
+    const T *batchInputs;
+    if constexpr (std::is_same_v<T, float>) {
+        batchInputs = inputs;
+    } else {
+        for (size_t k = 0; k < workspace.inputs.size(); ++k) {
+            workspace.inputs[k] = static_cast<T>(inputs[k]);
         }
+        batchInputs = workspace.inputs.data();
     }
 
-    for (std::size_t layerNum = m_layers.size() - 1; layerNum > 0; --layerNum) {
-        Layer &currentLayer = m_layers[layerNum];
-        Layer &prevLayer = m_layers[layerNum - 1];
-        // Skip bias neuron: it has no trainable incoming weights; prevLayer neurons
-        // only have m_outputWeights for non-bias targets (size = topology[layerNum])
-        for (std::size_t n = 0; n < currentLayer.size() - 1; ++n) {
-            currentLayer[n].updateInputWeights(prevLayer);
+    // forward pass for the whole batch
+    const T *prevOutputs = batchInputs;
+    for (size_t l = 0; l < numLayers; ++l) {
+        const std::uint64_t start = Profiler::now();
+        m_layers[l].feedForwardBatch(prevOutputs, batchSize, workspace.outputs[l].data());
+        if (workspace.recordProfile) profile(l, ProfilePhase::Forward, batchSize, start);
+        prevOutputs = workspace.outputs[l].data();
+    }
+
+    // per-sample RMS error, the same measure backPropagate uses
+    const size_t numOutputs = m_layers.back().getOutputCount();
+    const std::span<const T> outputVals = workspace.outputs.back();
+    for (size_t b = 0; b < batchSize; ++b) {
+        double error = 0.0;
+        for (size_t n = 0; n < numOutputs; ++n) {
+            const double delta = static_cast<double>(targets[b * numOutputs + n]) -
+                                 static_cast<double>(outputVals[b * numOutputs + n]);
+            error += delta * delta;
         }
+        workspace.sampleErrors[b] = sqrt(error / static_cast<double>(numOutputs));
+    }
+
+    // backward pass: gradients of every layer for every sample, then the weight gradients of
+    // each layer while its gradients are still in cache
+    for (size_t l = numLayers; l > 0; --l) {
+        const std::uint64_t start = Profiler::now();
+        const DenseLayer<T> &layer = m_layers[l - 1];
+        if (l == numLayers) {
+            layer.calculateOutputGradientsBatch(outputVals.data(), targets, batchSize, workspace.gradients[l - 1].data());
+        } else {
+            layer.calculateHiddenGradientsBatch(m_layers[l], workspace.gradients[l].data(),
+                                                workspace.outputs[l - 1].data(), batchSize,
+                                                workspace.gradients[l - 1].data());
+        }
+        const T *layerInputs = l == 1 ? batchInputs : workspace.outputs[l - 2].data();
+        layer.accumulateGradientsBatch(layerInputs, workspace.gradients[l - 1].data(), batchSize, scale,
+                                       workspace.weightGradients[l - 1].data(),
+                                       workspace.biasGradients[l - 1].data());
+        if (workspace.recordProfile) profile(l - 1, ProfilePhase::Backward, batchSize, start, true);
+    }
+}
+
+template<typename T>
+void BasicNet<T>::applyGradients(const Workspace &workspace) {
+    assert(workspace.weightGradients.size() == m_layers.size());
+    const std::uint64_t step = std::atomic_ref<std::uint64_t>(m_step).fetch_add(1, std::memory_order_relaxed) + 1;
+    for (size_t l = 0; l < m_layers.size(); ++l) {
+        const std::uint64_t start = Profiler::now();
+        m_layers[l].applyGradients(workspace.weightGradients[l].data(), workspace.biasGradients[l].data(),
+                                   m_optimizer, step);
+        profile(l, ProfilePhase::Update, 1, start);
+    }
+}
+
+template<typename T>
+void BasicNet<T>::recordErrors(const std::span<const double> sampleErrors) {
+    for (const double error : sampleErrors) {
+        m_error = error;
+        m_recentAverageError = (m_recentAverageError * m_recentAverageSmoothingFactor + error) /
+                               (m_recentAverageSmoothingFactor + 1.0);
+    }
+}
+
+template<typename T>
+void BasicNet<T>::Workspace::addGradients(const Workspace &other) {
+    assert(weightGradients.size() == other.weightGradients.size());
+    for (size_t l = 0; l < weightGradients.size(); ++l) {
+        kernels::axpy(weightGradients[l].size(), T(1), other.weightGradients[l].data(), weightGradients[l].data());
+        kernels::axpy(biasGradients[l].size(), T(1), other.biasGradients[l].data(), biasGradients[l].data());
+    }
+}
+
+template<typename T>
+void BasicNet<T>::predict(const T *inputs, const size_t batchSize, T *outputs, Workspace &workspace) const {
+    if (batchSize == 0) {
+        return;
+    }
+    const size_t numLayers = m_layers.size();
+    placeWorkspace(workspace, batchSize, false);
+
+    // the output layer writes straight into outputs, hidden layers into the workspace
+    const T *prevOutputs = inputs;
+    for (size_t l = 0; l < numLayers; ++l) {
+        T *layerOutputs = l + 1 < numLayers ? workspace.outputs[l].data() : outputs;
+        const std::uint64_t start = Profiler::now();
+        m_layers[l].feedForwardBatch(prevOutputs, batchSize, layerOutputs);
+        profile(l, ProfilePhase::Forward, batchSize, start);
+        prevOutputs = layerOutputs;
     }
 }
 
-void Net::getResults(vector<double> &resultValues) const {
-    resultValues.clear();
+template<typename T>
+void BasicNet<T>::predict(const T *inputs, const size_t batchSize, T *outputs) const {
+    thread_local Workspace workspace;
+    predict(inputs, batchSize, outputs, workspace);
+}
 
-    for (std::size_t n = 0; n < m_layers.back().size() - 1; ++n) {
-        resultValues.push_back(m_layers.back()[n].getOutputVal());
+template<typename T>
+vector<double> BasicNet<T>::predict(const vector<double> &inputValues) const {
+    assert(inputValues.size() == m_inputVals.size());
+    if constexpr (std::is_same_v<T, double>) {
+        vector<double> resultValues(getOutputCount());
+        predict(inputValues.data(), 1, resultValues.data());
+        return resultValues;
+    } else {
+        const vector<T> inputs(inputValues.begin(), inputValues.end());
+        vector<T> outputs(getOutputCount());
+        predict(inputs.data(), 1, outputs.data());
+        return {outputs.begin(), outputs.end()};
     }
 }
 
-[[nodiscard]] double Net::getRecentAverageError() const {
+template<typename T>
+void BasicNet<T>::getResults(vector<double> &resultValues) const {
+    const std::span<const T> outputVals = m_layers.back().getOutputs();
+    resultValues.assign(outputVals.begin(), outputVals.end());
+}
+
+template<typename T>
+double BasicNet<T>::getRecentAverageError() const {
     return m_recentAverageError;
 }
 
-size_t Net::getLayerCount() const {
-    return m_layers.size();
+template<typename T>
+Activation BasicNet<T>::getActivation(const size_t layerIndex) const {
+    assert(layerIndex > 0 && layerIndex < getLayerCount());
+    return m_layers[layerIndex - 1].getActivation();
+}
+
+template<typename T>
+void BasicNet<T>::setActivation(const size_t layerIndex, const Activation activation) {
+    assert(layerIndex > 0 && layerIndex < getLayerCount());
+    m_layers[layerIndex - 1].setActivation(activation);
+}
+
+template<typename T>
+vector<unsigned> BasicNet<T>::getTopology() const {
+    vector<unsigned> topology{static_cast<unsigned>(m_inputVals.size())};
+    for (const DenseLayer<T> &layer : m_layers) {
+        topology.push_back(static_cast<unsigned>(layer.getOutputCount()));
+    }
+    return topology;
+}
+
+template<typename T>
+void BasicNet<T>::setOptimizer(const Optimizer &optimizer) {
+    const bool sameRule = optimizer.type == m_optimizer.type;
+    const bool resize = optimizer.stateCount() != m_optimizer.stateCount();
+    m_optimizer = optimizer;
+    if (sameRule) {
+        return;
+    }
+    if (resize) {
+        placeArrays(m_inputVals.size(), hasMasterWeights());
+    }
+    for (DenseLayer<T> &layer : m_layers) {
+        layer.resetState();
+    }
+    m_step = 0;
+}
+
+template<typename T>
+void BasicNet<T>::setMasterWeights(const bool enabled) {
+    if (enabled != hasMasterWeights()) {
+        placeArrays(m_inputVals.size(), enabled);
+    }
+}
+
+template<typename T>
+size_t BasicNet<T>::getLayerCount() const {
+    return m_layers.size() + 1;
+}
+
+template<typename T>
+LayerView<T> BasicNet<T>::getLayer(size_t index) const {
+    assert(index < getLayerCount());
+    const std::span<const T> outputVals = index == 0 ? std::span<const T>(m_inputVals) : m_layers[index - 1].getOutputs();
+    const DenseLayer<T> *nextLayer = index < m_layers.size() ? &m_layers[index] : nullptr;
+    return {outputVals, nextLayer};
 }
 
-const Layer &Net::getLayer(size_t index) const {
-    return m_layers[index];
+template<typename T>
+void BasicNet<T>::save(const std::string &filename, const bool includeOptimizerState) const {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot create file: " + filename);
+    }
+
+    const std::size_t layerCount = m_layers.size() + 1;
+    const std::size_t optimizerOffset = optimizerFieldsOffset(layerCount);
+    const std::size_t headerEnd = optimizerOffset + OptimizerFieldsSize;
+    out.write(ModelMagic, sizeof(ModelMagic));
+    writeField<std::uint32_t>(out, ModelVersion);
+    writeField<std::uint32_t>(out, includeOptimizerState ? OptimizerStateFlag : 0);
+    writeField<std::uint32_t>(out, static_cast<std::uint32_t>(layerCount));
+    writeField<std::uint32_t>(out, optimizerCode(m_optimizer.type));
+    writeField<std::uint64_t>(out, alignUp(headerEnd));
+    writeField<std::uint32_t>(out, static_cast<std::uint32_t>(m_inputVals.size()));
+    for (const DenseLayer<T> &layer : m_layers) {
+        writeField<std::uint32_t>(out, static_cast<std::uint32_t>(layer.getOutputCount()));
+    }
+    for (const DenseLayer<T> &layer : m_layers) {
+        writeField<std::uint32_t>(out, activationCode(layer.getActivation()));
+    }
+    if (optimizerOffset > ModelHeaderSize + (2 * layerCount - 1) * sizeof(std::uint32_t)) {
+        writeField<std::uint32_t>(out, 0);
+    }
+    writeField<double>(out, m_optimizer.learningRate);
+    writeField<double>(out, m_optimizer.momentum);
+    writeField<double>(out, m_optimizer.decay);
+    writeField<double>(out, m_optimizer.epsilon);
+    writeField<std::uint64_t>(out, includeOptimizerState ? m_step : 0);
+
+    std::size_t offset = headerEnd;
+    for (const DenseLayer<T> &layer : m_layers) {
+        // master weights hold the parameters at full precision
+        if (layer.hasMasterWeights()) {
+            writeArray(out, offset, layer.getMasterWeights());
+            writeArray(out, offset, layer.getMasterBiases());
+        } else {
+            writeArray(out, offset, layer.getWeights());
+            writeArray(out, offset, layer.getBiases());
+        }
+        for (std::size_t slot = 0; includeOptimizerState && slot < layer.getStateCount(); ++slot) {
+            if (layer.hasMasterWeights()) {
+                writeArray(out, offset, layer.getMasterWeightState(slot));
+                writeArray(out, offset, layer.getMasterBiasState(slot));
+            } else {
+                writeArray(out, offset, layer.getWeightState(slot));
+                writeArray(out, offset, layer.getBiasState(slot));
+            }
+        }
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+template<typename T>
+BasicNet<T> BasicNet<T>::load(const std::string &filename) {
+    const MappedFile file(filename);
+    const unsigned char *data = file.data();
+    const std::size_t size = file.size();
+    if (size < ModelHeaderSize || std::memcmp(data, ModelMagic, sizeof(ModelMagic)) != 0) {
+        throw std::runtime_error("Not a model file: " + filename);
+    }
+    const auto version = readField<std::uint32_t>(data, 8);
+    if (version != 1 && version != ModelVersion) {
+        throw std::runtime_error("Unsupported model file version: " + filename);
+    }
+    const bool hasOptimizerState = (readField<std::uint32_t>(data, 12) & OptimizerStateFlag) != 0;
+    const std::size_t layerCount = readField<std::uint32_t>(data, 16);
+    std::size_t offset = static_cast<std::size_t>(readField<std::uint64_t>(data, 24));
+    if (layerCount < 2 || ModelHeaderSize + (2 * layerCount - 1) * sizeof(std::uint32_t) > size) {
+        throw std::runtime_error("Corrupt topology in model file: " + filename);
+    }
+
+    vector<unsigned> topology(layerCount);
+    vector<Activation> activations(layerCount - 1);
+    for (std::size_t l = 0; l < layerCount; ++l) {
+        topology[l] = readField<std::uint32_t>(data, ModelHeaderSize + l * sizeof(std::uint32_t));
+        if (topology[l] == 0) {
+            throw std::runtime_error("Corrupt topology in model file: " + filename);
+        }
+    }
+    for (std::size_t l = 0; l + 1 < layerCount; ++l) {
+        const auto code = readField<std::uint32_t>(data, ModelHeaderSize + (layerCount + l) * sizeof(std::uint32_t));
+        if (!activationFromCode(code, activations[l])) {
+            throw std::runtime_error("Unknown activation in model file: " + filename);
+        }
+    }
+
+    // version 1 files were trained with momentum SGD and store its deltas as the only state
+    Optimizer optimizer;
+    std::uint64_t step = 0;
+    if (version >= 2) {
+        const std::size_t fields = optimizerFieldsOffset(layerCount);
+        if (fields + OptimizerFieldsSize > size) {
+            throw std::runtime_error("Corrupt optimizer in model file: " + filename);
+        }
+        if (!optimizerFromCode(readField<std::uint32_t>(data, 20), optimizer.type)) {
+            throw std::runtime_error("Unknown optimizer in model file: " + filename);
+        }
+        optimizer.learningRate = readField<double>(data, fields);
+        optimizer.momentum = readField<double>(data, fields + sizeof(double));
+        optimizer.decay = readField<double>(data, fields + 2 * sizeof(double));
+        optimizer.epsilon = readField<double>(data, fields + 3 * sizeof(double));
+        step = readField<std::uint64_t>(data, fields + 4 * sizeof(double));
+    }
+
+    // the file must hold every array before the net allocates room for them; a corrupt topology
+    // would otherwise ask for any amount of memory
+    const std::size_t arraysPerParameter = hasOptimizerState ? 1 + optimizer.stateCount() : 1;
+    std::size_t valueCount = 0;
+    for (std::size_t l = 0; l + 1 < layerCount; ++l) {
+        const std::size_t outputs = topology[l + 1];
+        if (!addProduct(valueCount, std::size_t(topology[l]) + 1, outputs)) {
+            throw std::runtime_error("Corrupt topology in model file: " + filename);
+        }
+    }
+    std::size_t fileValues = 0;
+    if (offset > size || !addProduct(fileValues, valueCount, arraysPerParameter)
+        || fileValues > (size - offset) / sizeof(double)) {
+        throw std::runtime_error("Truncated model file: " + filename);
+    }
+
+    BasicNet net(topology, activations, false);
+    net.setOptimizer(optimizer);
+    net.m_step = hasOptimizerState ? step : 0;
+    // hands out the next aligned array of count doubles, checking it lies inside the file
+    const auto nextArray = [&](const std::size_t count) {
+        const std::size_t start = alignUp(offset);
+        if (start > size || count > (size - start) / sizeof(double)) {
+            throw std::runtime_error("Truncated model file: " + filename);
+        }
+        offset = start + count * sizeof(double);
+        return reinterpret_cast<const double *>(data + start);
+    };
+    for (DenseLayer<T> &layer : net.m_layers) {
+        const std::size_t weightCount = layer.getInputCount() * layer.getOutputCount();
+        const double *weights = nextArray(weightCount);
+        const double *biases = nextArray(layer.getOutputCount());
+        layer.setParameters(weights, biases);
+        for (std::size_t slot = 0; hasOptimizerState && slot < layer.getStateCount(); ++slot) {
+            const double *weightState = nextArray(weightCount);
+            const double *biasState = nextArray(layer.getOutputCount());
+            layer.setState(slot, weightState, biasState);
+        }
+    }
+    return net;
 }
 
-[[maybe_unused]] void Net::printPrediction(const vector<double> &inputValues) {
+template<typename T>
+void BasicNet<T>::printPrediction(const vector<double> &inputValues) {
     vector<double> resultValues;
     feedForward(inputValues);
     getResults(resultValues);
@@ -128,3 +740,6 @@ const Layer &Net::getLayer(size_t index) const {
     //    cout << resultValue << endl;
     //}
 }
+
+template class BasicNet<float>;
+template class BasicNet<double>;
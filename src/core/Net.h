@@ -4,16 +4,87 @@
 
 #ifndef XORGATE_NEURALNETWORK_NET_H
 #define XORGATE_NEURALNETWORK_NET_H
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
 #include <vector>
+#include "Activation.h"
+#include "Arena.h"
+#include "DenseLayer.h"
 #include "Neuron.h"
+#include "Optimizer.h"
+#include "Profiler.h"
 
 using namespace std;
-typedef vector<Neuron> Layer;
 
-class Net {
+// A fully connected network computing in scalar type T. BasicNet<double> (Net) is the reference;
+// BasicNet<float> halves memory traffic and doubles the SIMD width of every kernel, and can keep
+// double master weights (setMasterWeights) if its updates get too small for float. Inputs,
+// targets and results are exchanged as double vectors or float batches whatever T is.
+//
+// Every net owns its Optimizer, the update rule all training functions apply.
+//
+// All parameters, optimizer state, neuron outputs and gradients of a net are placed in one arena,
+// allocated when the net is built (or copied, or master weights or the number of optimizer state
+// arrays change). Training and prediction then run
+// without allocating: the scratch buffers of a Workspace only grow when a batch is larger than
+// every batch before it.
+template<typename T>
+class BasicNet {
 public:
+    // Scratch buffers and results of computeGradients, one entry per dense layer. They are placed
+    // in the workspace's own arena, which is replaced by a larger one only when a batch does not
+    // fit; every thread that computes gradients concurrently needs its own workspace.
+    struct Workspace {
+        std::span<T> inputs; // the batch converted to T (double nets only)
+        vector<std::span<T>> outputs;   // [batchSize x layer outputs]
+        vector<std::span<T>> gradients; // [batchSize x layer outputs]
+        vector<std::span<T>> weightGradients;
+        vector<std::span<T>> biasGradients;
+        std::span<double> sampleErrors; // RMS error of every sample
+        bool recordProfile = true; // false keeps passes through this workspace out of the net's profile
+
+        // adds the weight and bias gradients of other, e.g. those of another shard of the batch
+        void addGradients(const Workspace &other);
+
+        Arena arena;
+    };
+
     // topology is a vector of unsigned integers, it stands for the number of neurons in each layer
-    explicit Net(const vector<unsigned> &topology);
+    // activations holds the transfer function of every layer after the input layer (default: all tanh)
+    explicit BasicNet(const vector<unsigned> &topology, const vector<Activation> &activations = {});
+
+    // a copy gets its own arena holding the same values
+    BasicNet(const BasicNet &other);
+    BasicNet &operator=(const BasicNet &other);
+    BasicNet(BasicNet &&other) noexcept = default;
+    BasicNet &operator=(BasicNet &&other) noexcept = default;
+
+    // Model files (all little-endian):
+    //   offset  0  char[8]   magic "NNMODEL\0"
+    //           8  uint32    format version (2)
+    //          12  uint32    flags: bit 0 = optimizer state included
+    //          16  uint32    number of layers in the topology
+    //          20  uint32    optimizer (0 = momentum, 1 = nesterov, 2 = adam, 3 = rmsprop)
+    //          24  uint64    byte offset of the parameter block
+    //          32  uint32[]  topology, then one activation per layer after the input layer
+    //                        (0 = tanh, 1 = sigmoid, 2 = relu, 3 = linear)
+    //   8-aligned  float64[4] learning rate, momentum, decay, epsilon (see Optimizer)
+    //              uint64     number of updates applied
+    // The parameter block holds, for every layer after the input layer, its float64 weights
+    // [outputs x inputs] (row-major) and biases [outputs], followed by the optimizer's state
+    // arrays for weights and biases (one pair per Optimizer::stateCount) if included. Every array
+    // starts at a 64-byte aligned offset. Float nets convert on save and load, so one file serves
+    // nets of either precision. Version 1 files, which have no optimizer fields and store the
+    // momentum terms as the only state, are still read.
+
+    // writes topology, activations and parameters; throws std::runtime_error if the file cannot be written
+    void save(const std::string &filename, bool includeOptimizerState = true) const;
+
+    // reads a file written by save through a memory mapping; without optimizer state the optimizer
+    // starts from zero. Throws std::runtime_error on a missing or malformed file.
+    static BasicNet load(const std::string &filename);
 
     // FeedForward is used to calculate the output values
     void feedForward(const vector<double> &inputValues);
@@ -21,6 +92,38 @@ public:
     // backPropagate is used to calculate the error and adjust the weights
     void backPropagate(const vector<double> &targetValues);
 
+    // The update rule and its hyperparameters (default: Optimizer::sgd()). Switching to another
+    // type of rule starts its state over; changing only hyperparameters, e.g. the learning rate
+    // during training, keeps it.
+    void setOptimizer(const Optimizer &optimizer);
+    [[nodiscard]] const Optimizer &getOptimizer() const { return m_optimizer; }
+    // number of updates applied since the optimizer was chosen
+    [[nodiscard]] std::uint64_t getStep() const { return m_step; }
+
+    // trainBatch runs batchSize samples through the net at once and applies one weight update
+    // from their averaged gradients; inputs and targets are row-major, one sample per row
+    void trainBatch(const float *inputs, const float *targets, size_t batchSize);
+
+    // The two halves of trainBatch, so the gradients of a batch can be computed on several threads.
+    // computeGradients does not modify the net and fills workspace with scale times the summed
+    // gradients of the given samples; applyGradients performs the optimizer's update from them.
+    // Several threads may call applyGradients concurrently (see HogwildTrainer).
+    void computeGradients(const float *inputs, const float *targets, size_t batchSize, T scale,
+                          Workspace &workspace) const;
+    void applyGradients(const Workspace &workspace);
+
+    // folds per-sample errors into the recent average error, in sample order
+    void recordErrors(std::span<const double> sampleErrors);
+
+    // Inference without side effects: runs batchSize samples (row-major) through the net and writes
+    // the output values to outputs[batchSize x getOutputCount()]. Unlike feedForward it leaves the
+    // neuron outputs alone and keeps its intermediate values in workspace, so any number of threads
+    // can predict with the same net concurrently, as long as nobody trains it at the same time.
+    void predict(const T *inputs, size_t batchSize, T *outputs, Workspace &workspace) const;
+    // the same, using a workspace owned by the calling thread
+    void predict(const T *inputs, size_t batchSize, T *outputs) const;
+    [[nodiscard]] vector<double> predict(const vector<double> &inputValues) const;
+
     // get results is used to get the output values
     void getResults(vector<double> &resultValues) const;
 
@@ -28,16 +131,83 @@ public:
 
     [[maybe_unused]] void printPrediction(const vector<double> &inputValues);
 
-    // For visualization
+    // keep double master copies of all parameters and apply the updates to them (float nets)
+    void setMasterWeights(bool enabled);
+    [[nodiscard]] bool hasMasterWeights() const { return m_layers.front().hasMasterWeights(); }
+
+    // transfer function of a layer; layer 0 is the input layer and has none
+    [[nodiscard]] Activation getActivation(size_t layerIndex) const;
+    void setActivation(size_t layerIndex, Activation activation);
+
+    // neuron count of every layer, bias excluded, as passed to the constructor
+    [[nodiscard]] vector<unsigned> getTopology() const;
+    [[nodiscard]] size_t getInputCount() const { return m_inputVals.size(); }
+    [[nodiscard]] size_t getOutputCount() const { return m_layers.back().getOutputCount(); }
+
+    // For visualization; layer 0 is the input layer
     [[nodiscard]] size_t getLayerCount() const;
-    [[nodiscard]] const Layer &getLayer(size_t index) const;
+    [[nodiscard]] LayerView<T> getLayer(size_t index) const;
+    // the dense layer connecting layer index to layer index + 1, e.g. to export its parameters
+    [[nodiscard]] const DenseLayer<T> &getDenseLayer(size_t index) const { return m_layers[index]; }
+
+    // Views of the net's own arrays, without copying. They stay valid until the net is assigned,
+    // loaded into or its master weights are switched, and show updates as the net trains.
+    // Neuron values by layer (0 is the input layer), bias neuron excluded; the gradients are
+    // those of the last backPropagate and do not exist for the input layer.
+    [[nodiscard]] std::span<const T> getActivations(size_t layerIndex) const {
+        return layerIndex == 0 ? std::span<const T>(m_inputVals) : m_layers[layerIndex - 1].getOutputs();
+    }
+    [[nodiscard]] std::span<const T> getGradients(size_t layerIndex) const {
+        return m_layers[layerIndex - 1].getGradients();
+    }
+    // parameters connecting layer index to layer index + 1, as in getDenseLayer: the weights are
+    // [outputs x inputs] row-major, the biases are the weights of layer index's bias neuron
+    [[nodiscard]] std::span<const T> getWeights(size_t index) const { return m_layers[index].getWeights(); }
+    [[nodiscard]] std::span<const T> getBiases(size_t index) const { return m_layers[index].getBiases(); }
+
+    // Time, FLOPs, bytes and samples of every layer's forward, backward and update passes, counted
+    // when built with NN_ENABLE_PROFILING (see Profiler.h); predict counts as forward. A copy of
+    // a net starts with zeroed counters, assigning a net of the same topology keeps them.
+    [[nodiscard]] const Profiler &getProfiler() const { return m_profiler; }
+    // to reset the counters or keep a trace
+    [[nodiscard]] Profiler &getProfiler() { return m_profiler; }
 
 private:
-    vector<Layer> m_layers; // m_layers[layerNum][neuronNum]
+    // randomWeights == false leaves all parameters zero, for load
+    BasicNet(const vector<unsigned> &topology, const vector<Activation> &activations, bool randomWeights);
+
+    // moves the input values and all layer arrays into a new arena sized for them
+    void placeArrays(size_t inputCount, bool masterWeights);
+    // lays out workspace for batchSize samples; without training only the outputs
+    void placeWorkspace(Workspace &workspace, size_t batchSize, bool training) const;
+    // sizes the profiler for the layers, with zeroed counters
+    void initProfiler();
+    // adds a pass over samples samples of layer, which started at start (Profiler::now()), to the
+    // profile; weightGradients tells whether the pass also computed the layer's weight gradients
+    void profile(size_t layer, ProfilePhase phase, size_t samples, std::uint64_t start,
+                 bool weightGradients = false) const;
+
+    Arena m_arena; // holds m_inputVals and the arrays of every layer
+    std::span<T> m_inputVals; // outputs of the input layer
+    vector<DenseLayer<T>> m_layers; // m_layers[i] connects layer i to layer i + 1
     double m_error; // error is the average error of the output neurons
     double m_recentAverageError; // recentAverageError is the average error of the output neurons, but it is smoothed
     double m_recentAverageSmoothingFactor; // recentAverageSmoothingFactor is the smoothing factor for the recentAverageError
+
+    Optimizer m_optimizer;
+    // updates applied so far; counted atomically so that concurrent applyGradients number their steps
+    alignas(std::atomic_ref<std::uint64_t>::required_alignment) std::uint64_t m_step = 0;
+
+    Workspace m_workspace; // scratch for trainBatch
+
+    mutable Profiler m_profiler; // recorded by the const passes too, with atomic counters
 };
 
+extern template class BasicNet<float>;
+extern template class BasicNet<double>;
+
+using Net = BasicNet<double>;
+using FloatNet = BasicNet<float>;
+
 
 #endif //XORGATE_NEURALNETWORK_NET_H
@@ -5,53 +5,75 @@
 #ifndef XORGATE_NEURALNETWORK_NEURON_H
 #define XORGATE_NEURALNETWORK_NEURON_H
 
+#include <cstddef>
+#include <span>
 #include <vector>
 #include "Connection.h"
 
 using namespace std;
 
-class Neuron {
-public:
-    Neuron(unsigned numOutputs, unsigned myIndex);
+template<typename T>
+class DenseLayer;
 
-    void setOutputVal(double value);
+// NeuronView is a read-only view of one neuron inside the dense layers of a net with scalar type T.
+// The values live in the layers' contiguous arrays; a view only knows where to look.
+template<typename T>
+class NeuronView {
+public:
+    // outputVal points at the neuron's output (nullptr for a bias neuron, which always outputs 1.0),
+    // nextLayer is the layer this neuron feeds into (nullptr for the output layer)
+    NeuronView(const T *outputVal, const DenseLayer<T> *nextLayer, unsigned myIndex);
 
     [[nodiscard]] double getOutputVal() const;
 
-    // this function is used for calculating the output of the neurons
-    void feedForward(const vector<Neuron> &prevLayer);
+    // the connections to every neuron of the next layer (bias excluded); this copies them, code
+    // that reads many weights should use the spans of Net::getWeights and Net::getBiases
+    [[nodiscard]] vector<Connection> getOutputWeights() const;
+
+private:
+    const T *m_outputVal;
+    const DenseLayer<T> *m_nextLayer;
+    unsigned m_myIndex;
+};
 
-    // used by the backpropagation, calculate the gradient (Steigung) of the output neurons
-    void calculateOutputGradients(double targetValue);
+// LayerView is a read-only view of one layer of a net, including the trailing bias neuron.
+template<typename T>
+class LayerView {
+public:
+    class Iterator {
+    public:
+        Iterator(const LayerView *layer, std::size_t index) : m_layer(layer), m_index(index) {}
+        NeuronView<T> operator*() const { return (*m_layer)[m_index]; }
+        Iterator &operator++() { ++m_index; return *this; }
+        bool operator!=(const Iterator &other) const { return m_index != other.m_index; }
 
-    // the difference to the output neurons is that the hidden neurons don't have a target value
-    void calculateHiddenGradients(const vector<Neuron> &nextLayer);
+    private:
+        const LayerView *m_layer;
+        std::size_t m_index;
+    };
 
-    void updateInputWeights(vector<Neuron> &prevLayer) const;
+    // outputVals holds the outputs of the non-bias neurons
+    LayerView(std::span<const T> outputVals, const DenseLayer<T> *nextLayer);
 
-    [[nodiscard]] vector<Connection> getOutputWeights() const;
+    // number of neurons, bias neuron included
+    [[nodiscard]] std::size_t size() const;
+    NeuronView<T> operator[](std::size_t index) const;
 
-    // Modifiable training parameters (apply before training)
-    static void setEta(double value);
-    static void setAlpha(double value);
-    static double getEta();
-    static double getAlpha();
+    [[nodiscard]] Iterator begin() const { return {this, 0}; }
+    [[nodiscard]] Iterator end() const { return {this, size()}; }
 
 private:
-    unsigned m_myIndex;
-    double m_outputVal{};
-    vector<Connection> m_outputWeights;
-    double m_gradient{}; // used by the backpropagation, gradient of the error function, which is the slope of the error function
-
-    static double eta;
-    static double alpha;
-
-    static double sigmoid(double x); // output range [0.0..1.0], smooth curve
-    static double ReLu(double x);
-    static double transferFunction(double x); // tanh - output range [-1.0..1.0], smooth curve
-    static double transferFunctionDerivative(double x); // tanh derivative
-    [[nodiscard]] double sumDOW(const vector<Neuron> &nextLayer) const; // sum of the derivatives of the weights of the next layer
+    std::span<const T> m_outputVals;
+    const DenseLayer<T> *m_nextLayer;
 };
 
+extern template class NeuronView<float>;
+extern template class NeuronView<double>;
+extern template class LayerView<float>;
+extern template class LayerView<double>;
+
+// the views of a double-precision Net
+using Layer = LayerView<double>;
+
 
 #endif //XORGATE_NEURALNETWORK_NEURON_H
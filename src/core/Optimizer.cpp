@@ -0,0 +1,141 @@
+//
+// Update rules that turn gradients into parameter changes.
+//
+
+#include "Optimizer.h"
+#include "Kernels.h"
+#include <cmath>
+
+namespace {
+
+constexpr OptimizerType OptimizerTypes[] = {OptimizerType::Momentum, OptimizerType::Nesterov, OptimizerType::Adam,
+                                            OptimizerType::RMSProp};
+
+// Adam's bias correction, folded into the step size and epsilon:
+// lr * mHat / (sqrt(vHat) + eps) == stepSize * m / (sqrt(v) + epsilon)
+struct AdamStep {
+    double stepSize;
+    double epsilon;
+};
+
+AdamStep adamStep(const Optimizer &optimizer, const std::uint64_t step) {
+    const double t = static_cast<double>(step);
+    const double correction1 = 1.0 - std::pow(optimizer.momentum, t);
+    const double root2 = std::sqrt(1.0 - std::pow(optimizer.decay, t));
+    return {optimizer.learningRate * root2 / correction1, optimizer.epsilon * root2};
+}
+
+}
+
+const char *optimizerName(const OptimizerType type) {
+    switch (type) {
+        case OptimizerType::Momentum: return "momentum";
+        case OptimizerType::Nesterov: return "nesterov";
+        case OptimizerType::Adam: return "adam";
+        case OptimizerType::RMSProp: return "rmsprop";
+    }
+    return "momentum";
+}
+
+bool parseOptimizer(const std::string &name, OptimizerType &type) {
+    for (const OptimizerType candidate : OptimizerTypes) {
+        if (name == optimizerName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+Optimizer Optimizer::sgd(const double learningRate, const double momentum) {
+    return {OptimizerType::Momentum, learningRate, momentum};
+}
+
+Optimizer Optimizer::nesterov(const double learningRate, const double momentum) {
+    return {OptimizerType::Nesterov, learningRate, momentum};
+}
+
+Optimizer Optimizer::adam(const double learningRate, const double beta1, const double beta2, const double epsilon) {
+    return {OptimizerType::Adam, learningRate, beta1, beta2, epsilon};
+}
+
+Optimizer Optimizer::rmsProp(const double learningRate, const double decay, const double epsilon) {
+    return {OptimizerType::RMSProp, learningRate, 0.0, decay, epsilon};
+}
+
+template<typename T>
+void Optimizer::apply(const std::uint64_t step, const std::size_t n, const double scale, const T *x, T *w,
+                      T *state0, T *state1) const {
+    switch (type) {
+        case OptimizerType::Momentum:
+            kernels::momentumAxpy(n, static_cast<T>(learningRate * scale), x, static_cast<T>(momentum), state0, w);
+            break;
+        case OptimizerType::Nesterov:
+            kernels::nesterovAxpy(n, static_cast<T>(learningRate * scale), x, static_cast<T>(momentum), state0, w);
+            break;
+        case OptimizerType::Adam: {
+            const AdamStep corrected = adamStep(*this, step);
+            kernels::adamStep(n, static_cast<T>(scale), x, static_cast<T>(momentum), static_cast<T>(decay),
+                              static_cast<T>(corrected.stepSize), static_cast<T>(corrected.epsilon), state0, state1, w);
+            break;
+        }
+        case OptimizerType::RMSProp:
+            kernels::rmsPropStep(n, static_cast<T>(scale), x, static_cast<T>(decay), static_cast<T>(learningRate),
+                                 static_cast<T>(epsilon), state0, w);
+            break;
+    }
+}
+
+template<typename T>
+void Optimizer::applyMaster(const std::uint64_t step, const std::size_t n, const double scale, const T *x,
+                            double *master, double *masterState0, double *masterState1, T *w, T *state0,
+                            T *state1) const {
+    switch (type) {
+        case OptimizerType::Momentum:
+        case OptimizerType::Nesterov: {
+            const double alpha = learningRate * scale;
+            const bool nesterov = type == OptimizerType::Nesterov;
+            for (std::size_t i = 0; i < n; ++i) {
+                const double d = alpha * static_cast<double>(x[i]) + momentum * masterState0[i];
+                masterState0[i] = d;
+                master[i] += nesterov ? alpha * static_cast<double>(x[i]) + momentum * d : d;
+            }
+            break;
+        }
+        case OptimizerType::Adam: {
+            const AdamStep corrected = adamStep(*this, step);
+            for (std::size_t i = 0; i < n; ++i) {
+                const double g = scale * static_cast<double>(x[i]);
+                masterState0[i] = momentum * masterState0[i] + (1.0 - momentum) * g;
+                masterState1[i] = decay * masterState1[i] + (1.0 - decay) * g * g;
+                master[i] += corrected.stepSize * masterState0[i] / (std::sqrt(masterState1[i]) + corrected.epsilon);
+            }
+            break;
+        }
+        case OptimizerType::RMSProp:
+            for (std::size_t i = 0; i < n; ++i) {
+                const double g = scale * static_cast<double>(x[i]);
+                masterState0[i] = decay * masterState0[i] + (1.0 - decay) * g * g;
+                master[i] += learningRate * g / (std::sqrt(masterState0[i]) + epsilon);
+            }
+            break;
+    }
+
+    // the working copies follow the masters
+    for (std::size_t i = 0; i < n; ++i) {
+        w[i] = static_cast<T>(master[i]);
+        state0[i] = static_cast<T>(masterState0[i]);
+    }
+    if (stateCount() > 1) {
+        for (std::size_t i = 0; i < n; ++i) {
+            state1[i] = static_cast<T>(masterState1[i]);
+        }
+    }
+}
+
+template void Optimizer::apply(std::uint64_t, std::size_t, double, const float *, float *, float *, float *) const;
+template void Optimizer::apply(std::uint64_t, std::size_t, double, const double *, double *, double *, double *) const;
+template void Optimizer::applyMaster(std::uint64_t, std::size_t, double, const float *, double *, double *, double *,
+                                     float *, float *, float *) const;
+template void Optimizer::applyMaster(std::uint64_t, std::size_t, double, const double *, double *, double *,
+                                     double *, double *, double *, double *) const;
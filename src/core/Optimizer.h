@@ -0,0 +1,61 @@
+//
+// Update rules that turn gradients into parameter changes.
+//
+
+#ifndef XORGATE_NEURALNETWORK_OPTIMIZER_H
+#define XORGATE_NEURALNETWORK_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class OptimizerType {
+    Momentum, // SGD with classical momentum: delta = eta * g + alpha * delta, w += delta
+    Nesterov, // SGD with Nesterov momentum, which looks one step ahead along delta
+    Adam,     // per-parameter step sizes from running means of g and g^2, bias corrected
+    RMSProp   // per-parameter step sizes from a running mean of g^2
+};
+
+// lower-case name ("momentum", "nesterov", "adam", "rmsprop"), used in files and on the command line
+const char *optimizerName(OptimizerType type);
+
+// parses a name produced by optimizerName; returns false for unknown names
+bool parseOptimizer(const std::string &name, OptimizerType &type);
+
+// An Optimizer is the update rule of one net together with its hyperparameters; every net owns
+// its own, so nets with different settings can train at the same time. The per-parameter state
+// (momentum terms, moment estimates) lives in the net's layers, next to the parameters, in
+// stateCount() arrays per parameter array.
+//
+// g is always the direction that lowers the error (the negative gradient of the loss), so every
+// rule adds to the weights.
+struct Optimizer {
+    OptimizerType type = OptimizerType::Momentum;
+    double learningRate = 0.15;
+    double momentum = 0.5; // Momentum, Nesterov: multiplier of the last step; Adam: beta1
+    double decay = 0.999;  // Adam: beta2; RMSProp: decay of the mean square
+    double epsilon = 1e-8; // Adam, RMSProp: added to the root mean square to avoid dividing by 0
+
+    static Optimizer sgd(double learningRate = 0.15, double momentum = 0.5);
+    static Optimizer nesterov(double learningRate = 0.15, double momentum = 0.5);
+    static Optimizer adam(double learningRate = 0.001, double beta1 = 0.9, double beta2 = 0.999,
+                          double epsilon = 1e-8);
+    static Optimizer rmsProp(double learningRate = 0.001, double decay = 0.9, double epsilon = 1e-8);
+
+    // state arrays per parameter array: 2 for Adam, 1 otherwise
+    [[nodiscard]] std::size_t stateCount() const { return type == OptimizerType::Adam ? 2 : 1; }
+
+    // Update number step (counting from 1) of n parameters w with g = scale * x, through the
+    // vectorized kernels. Adam's bias correction depends on step; the other rules ignore it.
+    template<typename T>
+    void apply(std::uint64_t step, std::size_t n, double scale, const T *x, T *w, T *state0, T *state1) const;
+
+    // The same update on double master copies of the parameters and their state, after which the
+    // working copies (of type T) are refreshed from them; see DenseLayer's master weights.
+    template<typename T>
+    void applyMaster(std::uint64_t step, std::size_t n, double scale, const T *x, double *master,
+                     double *masterState0, double *masterState1, T *w, T *state0, T *state1) const;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_OPTIMIZER_H
@@ -0,0 +1,123 @@
+//
+// Data-parallel mini-batch training on a pool of worker threads.
+//
+
+#include "ParallelTrainer.h"
+#include <algorithm>
+#include <type_traits>
+
+ParallelTrainer::ParallelTrainer(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_shards = std::vector<Shard>(threadCount);
+    m_workers.reserve(threadCount - 1);
+    for (std::size_t shard = 1; shard < threadCount; ++shard) {
+        m_workers.emplace_back(&ParallelTrainer::workerLoop, this, shard);
+    }
+}
+
+ParallelTrainer::~ParallelTrainer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobPosted.notify_all();
+    for (std::thread &worker : m_workers) {
+        worker.join();
+    }
+}
+
+template<typename T>
+void ParallelTrainer::trainBatch(BasicNet<T> &net, const float *inputs, const float *targets,
+                                 const std::size_t batchSize) {
+    const std::size_t shardCount = std::min(m_shards.size(), std::max<std::size_t>(1, batchSize / minSamplesPerShard));
+    if (shardCount <= 1) {
+        net.trainBatch(inputs, targets, batchSize);
+        return;
+    }
+
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job.generation++;
+        m_job.net = &net;
+        m_job.runShard = &ParallelTrainer::runShard<T>;
+        m_job.inputs = inputs;
+        m_job.targets = targets;
+        m_job.batchSize = batchSize;
+        m_job.shardCount = shardCount;
+        job = m_job;
+    }
+    m_jobPosted.notify_all();
+
+    // shard 0 only returns once the whole tree below it, i.e. every shard, has been summed into it
+    runShard<T>(job, 0);
+
+    for (std::size_t shard = 0; shard < shardCount; ++shard) {
+        net.recordErrors(workspace<T>(shard).sampleErrors);
+    }
+    net.applyGradients(workspace<T>(0));
+}
+
+void ParallelTrainer::workerLoop(const std::size_t shard) {
+    std::uint64_t seen = 0;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobPosted.wait(lock, [&] { return m_stop || m_job.generation != seen; });
+            if (m_stop) {
+                return;
+            }
+            job = m_job;
+            seen = job.generation;
+        }
+        if (shard < job.shardCount) {
+            (this->*job.runShard)(job, shard);
+        }
+    }
+}
+
+template<typename T>
+void ParallelTrainer::runShard(const Job &job, const std::size_t shard) {
+    const auto *net = static_cast<const BasicNet<T> *>(job.net);
+    const std::size_t numInputs = net->getInputCount();
+    const std::size_t numOutputs = net->getOutputCount();
+    const std::size_t begin = job.batchSize * shard / job.shardCount;
+    const std::size_t end = job.batchSize * (shard + 1) / job.shardCount;
+
+    // every shard is scaled by the full batch size, so the shards sum to the batch average
+    typename BasicNet<T>::Workspace &own = workspace<T>(shard);
+    net->computeGradients(job.inputs + begin * numInputs, job.targets + begin * numOutputs, end - begin,
+                          T(1) / static_cast<T>(job.batchSize), own);
+
+    // tree reduction: take in the partner at distance 1, 2, 4, ... until this shard is not the left
+    // half of a pair any more
+    for (std::size_t stride = 1; shard % (2 * stride) == 0 && shard + stride < job.shardCount; stride *= 2) {
+        const std::size_t partner = shard + stride;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_shardReduced.wait(lock, [&] { return m_shards[partner].reduced == job.generation; });
+        }
+        own.addGradients(workspace<T>(partner));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shards[shard].reduced = job.generation;
+    }
+    m_shardReduced.notify_all();
+}
+
+template<typename T>
+typename BasicNet<T>::Workspace &ParallelTrainer::workspace(const std::size_t shard) {
+    if constexpr (std::is_same_v<T, float>) {
+        return m_shards[shard].floatWorkspace;
+    } else {
+        return m_shards[shard].doubleWorkspace;
+    }
+}
+
+template void ParallelTrainer::trainBatch(BasicNet<float> &, const float *, const float *, std::size_t);
+template void ParallelTrainer::trainBatch(BasicNet<double> &, const float *, const float *, std::size_t);
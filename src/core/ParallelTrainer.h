@@ -0,0 +1,78 @@
+//
+// Data-parallel mini-batch training on a pool of worker threads.
+//
+
+#ifndef XORGATE_NEURALNETWORK_PARALLELTRAINER_H
+#define XORGATE_NEURALNETWORK_PARALLELTRAINER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Net.h"
+
+// Splits every mini-batch into one shard per thread. Each shard's gradients are computed into its
+// own Net::Workspace, the workspaces are summed pairwise in a tree (shard i takes in shard i + 1,
+// then i + 2, i + 4, ... as soon as they are complete) and shard 0 ends up holding the gradient of
+// the whole batch, from which the calling thread applies a single weight update. The result is the
+// same update Net::trainBatch makes, up to the order of the floating point sums.
+//
+// The calling thread works on shard 0, so a trainer with threadCount threads starts threadCount - 1
+// workers. They live as long as the trainer and sleep between batches. One trainer can drive nets
+// of either precision.
+class ParallelTrainer {
+public:
+    // threadCount == 0 uses one thread per hardware thread
+    explicit ParallelTrainer(unsigned threadCount = 0);
+    ~ParallelTrainer();
+
+    ParallelTrainer(const ParallelTrainer &) = delete;
+    ParallelTrainer &operator=(const ParallelTrainer &) = delete;
+
+    [[nodiscard]] unsigned getThreadCount() const { return static_cast<unsigned>(m_shards.size()); }
+
+    // trains net on batchSize samples, same layout as Net::trainBatch
+    template<typename T>
+    void trainBatch(BasicNet<T> &net, const float *inputs, const float *targets, std::size_t batchSize);
+
+private:
+    // batches are only split while every shard keeps at least this many samples; smaller shards
+    // cost more in wake-ups and reductions than they save
+    static constexpr std::size_t minSamplesPerShard = 4;
+
+    struct Job {
+        std::uint64_t generation = 0;
+        const void *net = nullptr; // a BasicNet<float> or BasicNet<double>, see runShard
+        void (ParallelTrainer::*runShard)(const Job &, std::size_t) = nullptr;
+        const float *inputs = nullptr;
+        const float *targets = nullptr;
+        std::size_t batchSize = 0;
+        std::size_t shardCount = 0;
+    };
+
+    struct alignas(64) Shard {
+        BasicNet<float>::Workspace floatWorkspace;
+        BasicNet<double>::Workspace doubleWorkspace;
+        std::uint64_t reduced = 0; // generation whose subtree this shard has finished summing
+    };
+
+    void workerLoop(std::size_t shard);
+    template<typename T>
+    void runShard(const Job &job, std::size_t shard);
+    template<typename T>
+    typename BasicNet<T>::Workspace &workspace(std::size_t shard);
+
+    std::vector<Shard> m_shards;
+    std::vector<std::thread> m_workers; // m_workers[i] works on shard i + 1
+
+    std::mutex m_mutex; // guards m_job, m_stop and Shard::reduced
+    std::condition_variable m_jobPosted;
+    std::condition_variable m_shardReduced;
+    Job m_job;
+    bool m_stop = false;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_PARALLELTRAINER_H
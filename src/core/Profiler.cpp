@@ -0,0 +1,159 @@
+//
+// Per-layer timing counters of a net's passes.
+//
+
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// slots of Counters::values
+enum Field { Calls, Samples, Nanoseconds, Flops, Bytes };
+
+constexpr ProfilePhase ProfilePhases[] = {ProfilePhase::Forward, ProfilePhase::Backward, ProfilePhase::Update};
+
+void add(std::uint64_t &counter, const std::uint64_t value) {
+    std::atomic_ref<std::uint64_t>(counter).fetch_add(value, std::memory_order_relaxed);
+}
+
+std::uint64_t load(const std::uint64_t &counter) {
+    return std::atomic_ref<const std::uint64_t>(counter).load(std::memory_order_relaxed);
+}
+
+// small, stable ids for the threads that record, in the order they first do
+std::uint32_t threadId() {
+    static std::atomic<std::uint32_t> nextId{1};
+    thread_local const std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void writeFile(const std::string &filename, const std::string &text) {
+    std::ofstream out(filename);
+    out << text;
+    if (!out) {
+        throw std::runtime_error("Cannot write " + filename);
+    }
+}
+
+}
+
+const char *profilePhaseName(const ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::Forward: return "forward";
+        case ProfilePhase::Backward: return "backward";
+        case ProfilePhase::Update: return "update";
+    }
+    return "forward";
+}
+
+void Profiler::setLayers(const std::vector<std::array<std::size_t, 2>> &shapes) {
+    m_layers.assign(shapes.size(), Counters());
+    for (std::size_t l = 0; l < shapes.size(); ++l) {
+        m_layers[l].inputs = shapes[l][0];
+        m_layers[l].outputs = shapes[l][1];
+    }
+    reset();
+}
+
+void Profiler::record(const std::size_t layer, const ProfilePhase phase, const std::uint64_t samples,
+                      const std::uint64_t flops, const std::uint64_t bytes, const std::uint64_t start,
+                      const std::uint64_t end) {
+    assert(layer < m_layers.size());
+    const std::uint64_t duration = end - start;
+    auto &values = m_layers[layer].values[static_cast<std::size_t>(phase)];
+    add(values[Calls], 1);
+    add(values[Samples], samples);
+    add(values[Nanoseconds], duration);
+    add(values[Flops], flops);
+    add(values[Bytes], bytes);
+
+    if (m_events.empty()) {
+        return;
+    }
+    const std::uint64_t slot = std::atomic_ref<std::uint64_t>(m_eventCount).fetch_add(1, std::memory_order_relaxed);
+    if (slot < m_events.size()) {
+        m_events[slot] = {start - m_origin, duration, samples, static_cast<std::uint32_t>(layer),
+                          static_cast<std::uint32_t>(phase), threadId()};
+    }
+}
+
+void Profiler::reset() {
+    for (Counters &counters : m_layers) {
+        counters.values = {};
+    }
+    m_eventCount = 0;
+    m_origin = now();
+}
+
+void Profiler::setTraceCapacity(const std::size_t events) {
+    m_events.assign(events, TraceEvent());
+    m_eventCount = 0;
+}
+
+std::size_t Profiler::getTraceEventCount() const {
+    return static_cast<std::size_t>(std::min<std::uint64_t>(load(m_eventCount), m_events.size()));
+}
+
+std::vector<LayerProfile> Profiler::getLayers() const {
+    std::vector<LayerProfile> layers(m_layers.size());
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        layers[l].inputs = m_layers[l].inputs;
+        layers[l].outputs = m_layers[l].outputs;
+        for (std::size_t p = 0; p < ProfilePhaseCount; ++p) {
+            const auto &values = m_layers[l].values[p];
+            layers[l].phases[p] = {load(values[Calls]), load(values[Samples]), load(values[Nanoseconds]),
+                                   load(values[Flops]), load(values[Bytes])};
+        }
+    }
+    return layers;
+}
+
+std::string Profiler::toJson() const {
+    const std::vector<LayerProfile> layers = getLayers();
+    std::ostringstream out;
+    out << "{\n  \"enabled\": " << (profilingEnabled ? "true" : "false") << ",\n  \"layers\": [";
+    for (std::size_t l = 0; l < layers.size(); ++l) {
+        out << (l == 0 ? "\n" : ",\n") << "    {\"layer\": " << l << ", \"inputs\": " << layers[l].inputs
+            << ", \"outputs\": " << layers[l].outputs;
+        for (const ProfilePhase phase : ProfilePhases) {
+            const PhaseStats &stats = layers[l][phase];
+            out << ", \"" << profilePhaseName(phase) << "\": {\"calls\": " << stats.calls
+                << ", \"samples\": " << stats.samples << ", \"ns\": " << stats.nanoseconds
+                << ", \"flops\": " << stats.flops << ", \"bytes\": " << stats.bytes << "}";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+std::string Profiler::toChromeTrace() const {
+    std::ostringstream out;
+    out.precision(3);
+    out << std::fixed << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    const std::size_t count = getTraceEventCount();
+    for (std::size_t i = 0; i < count; ++i) {
+        const TraceEvent &event = m_events[i];
+        const char *phase = profilePhaseName(static_cast<ProfilePhase>(event.phase));
+        // timestamps and durations are in microseconds
+        out << (i == 0 ? "\n" : ",\n") << "  {\"name\": \"layer " << event.layer << " " << phase
+            << "\", \"cat\": \"" << phase << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+            << ", \"ts\": " << static_cast<double>(event.start) / 1000.0
+            << ", \"dur\": " << static_cast<double>(event.duration) / 1000.0
+            << ", \"args\": {\"layer\": " << event.layer << ", \"samples\": " << event.samples << "}}";
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+void Profiler::saveJson(const std::string &filename) const {
+    writeFile(filename, toJson());
+}
+
+void Profiler::saveChromeTrace(const std::string &filename) const {
+    writeFile(filename, toChromeTrace());
+}
@@ -0,0 +1,127 @@
+//
+// Per-layer timing counters of a net's passes.
+//
+
+#ifndef XORGATE_NEURALNETWORK_PROFILER_H
+#define XORGATE_NEURALNETWORK_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Instrumentation is compiled in with NN_ENABLE_PROFILING (the CMake option of the same name);
+// without it the timing calls in the net compile to nothing and every profile stays empty.
+#ifdef NN_ENABLE_PROFILING
+inline constexpr bool profilingEnabled = true;
+#else
+inline constexpr bool profilingEnabled = false;
+#endif
+
+// forward: the layer's outputs; backward: its neuron gradients and, when training in batches,
+// the summed weight gradients; update: the optimizer step (training sample by sample computes
+// the weight gradients in it)
+enum class ProfilePhase { Forward, Backward, Update };
+inline constexpr std::size_t ProfilePhaseCount = 3;
+
+const char *profilePhaseName(ProfilePhase phase);
+
+struct PhaseStats {
+    std::uint64_t calls = 0;
+    std::uint64_t samples = 0; // for update: optimizer steps, as batched training updates once per batch
+    std::uint64_t nanoseconds = 0;
+    std::uint64_t flops = 0;
+    // bytes the phase has to move at least: the parameters once per call, activations per sample
+    std::uint64_t bytes = 0;
+
+    [[nodiscard]] double gflops() const {
+        return nanoseconds == 0 ? 0.0 : static_cast<double>(flops) / static_cast<double>(nanoseconds);
+    }
+};
+
+// the counters of one dense layer; layer 0 connects the input layer to the first hidden layer
+struct LayerProfile {
+    std::size_t inputs = 0;
+    std::size_t outputs = 0;
+    std::array<PhaseStats, ProfilePhaseCount> phases;
+
+    [[nodiscard]] const PhaseStats &operator[](ProfilePhase phase) const {
+        return phases[static_cast<std::size_t>(phase)];
+    }
+};
+
+// A Profiler collects the counters of every layer of one net. Any number of threads may record
+// at the same time (the trainers compute gradients of one net on several threads); reading the
+// stats while they do gives a consistent value per counter, not across counters. reset and
+// setTraceCapacity must not run concurrently with recording.
+//
+// Besides the sums, the profiler can keep every recorded span as a trace event, up to a capacity
+// chosen with setTraceCapacity (none by default), for chrome://tracing or Perfetto. Read the
+// trace once recording has stopped; events still being written would show up half filled in.
+class Profiler {
+public:
+    // nanoseconds on a monotonic clock; 0 without NN_ENABLE_PROFILING
+    [[nodiscard]] static std::uint64_t now() {
+        if constexpr (profilingEnabled) {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        } else {
+            return 0;
+        }
+    }
+
+    // sets the shape of every layer as {inputs, outputs} and zeroes all counters
+    void setLayers(const std::vector<std::array<std::size_t, 2>> &shapes);
+
+    // adds one call of phase on layer that ran from start to end (see now)
+    void record(std::size_t layer, ProfilePhase phase, std::uint64_t samples, std::uint64_t flops,
+                std::uint64_t bytes, std::uint64_t start, std::uint64_t end);
+
+    // zeroes all counters and drops the trace events
+    void reset();
+
+    // keeps up to events trace events from now on; later spans only count in the sums
+    void setTraceCapacity(std::size_t events);
+    [[nodiscard]] std::size_t getTraceEventCount() const;
+
+    // a snapshot of the counters of every layer
+    [[nodiscard]] std::vector<LayerProfile> getLayers() const;
+
+    // {"layers": [{"layer", "inputs", "outputs", "forward": {calls, samples, ns, flops, bytes}, ...}]}
+    [[nodiscard]] std::string toJson() const;
+    // the trace events in Chrome's trace event format, one complete ("X") event per span
+    [[nodiscard]] std::string toChromeTrace() const;
+
+    // write toJson or toChromeTrace; throw std::runtime_error if the file cannot be written
+    void saveJson(const std::string &filename) const;
+    void saveChromeTrace(const std::string &filename) const;
+
+private:
+    struct Counters {
+        std::size_t inputs = 0;
+        std::size_t outputs = 0;
+        // [phase][calls, samples, nanoseconds, flops, bytes], added to through std::atomic_ref
+        alignas(std::atomic_ref<std::uint64_t>::required_alignment)
+            std::array<std::array<std::uint64_t, 5>, ProfilePhaseCount> values{};
+    };
+
+    struct TraceEvent {
+        std::uint64_t start;
+        std::uint64_t duration;
+        std::uint64_t samples;
+        std::uint32_t layer;
+        std::uint32_t phase;
+        std::uint32_t thread;
+    };
+
+    std::vector<Counters> m_layers;
+    std::vector<TraceEvent> m_events; // sized to the capacity, the first m_eventCount are used
+    alignas(std::atomic_ref<std::uint64_t>::required_alignment) std::uint64_t m_eventCount = 0;
+    std::uint64_t m_origin = now(); // start of the trace, set again by reset
+};
+
+
+#endif //XORGATE_NEURALNETWORK_PROFILER_H
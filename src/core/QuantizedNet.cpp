@@ -0,0 +1,153 @@
+//
+// Int8 inference on a copy of a trained net.
+//
+
+#include "QuantizedNet.h"
+#include "Kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+constexpr std::size_t blockSize = 64; // gemvU8S8 consumes rows in blocks of this many bytes
+constexpr float maxWeight = 127.0f;
+constexpr float maxInput = 127.0f; // 7 bits, see QuantizedNet.h
+
+std::size_t roundUp(const std::size_t value, const std::size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+}
+
+template<typename T>
+QuantizedNet::QuantizedNet(const BasicNet<T> &net) {
+    const std::size_t numLayers = net.getLayerCount() - 1;
+    m_layers.reserve(numLayers);
+    for (std::size_t l = 0; l < numLayers; ++l) {
+        const DenseLayer<T> &dense = net.getDenseLayer(l);
+        Layer layer;
+        layer.numInputs = dense.getInputCount();
+        layer.numOutputs = dense.getOutputCount();
+        layer.stride = roundUp(layer.numInputs, blockSize);
+        layer.activation = dense.getActivation();
+        layer.weights.assign(layer.numOutputs * layer.stride, 0);
+        layer.weightScales.resize(layer.numOutputs);
+        layer.rowSums.resize(layer.numOutputs);
+        layer.biases.resize(layer.numOutputs);
+
+        for (std::size_t o = 0; o < layer.numOutputs; ++o) {
+            const T *row = dense.getWeights().data() + o * layer.numInputs;
+            double maxAbs = 0.0;
+            for (std::size_t i = 0; i < layer.numInputs; ++i) {
+                maxAbs = std::max(maxAbs, std::abs(static_cast<double>(row[i])));
+            }
+            // an all-zero row keeps scale 1 and quantizes to zeros
+            const double scale = maxAbs > 0.0 ? maxAbs / maxWeight : 1.0;
+
+            std::int8_t *quantized = layer.weights.data() + o * layer.stride;
+            std::int32_t rowSum = 0;
+            for (std::size_t i = 0; i < layer.numInputs; ++i) {
+                const double q = std::clamp(std::round(static_cast<double>(row[i]) / scale),
+                                            -static_cast<double>(maxWeight), static_cast<double>(maxWeight));
+                quantized[i] = static_cast<std::int8_t>(q);
+                rowSum += quantized[i];
+            }
+            layer.weightScales[o] = static_cast<float>(scale);
+            layer.rowSums[o] = rowSum;
+            layer.biases[o] = static_cast<float>(dense.getBias(o));
+        }
+        m_layers.push_back(std::move(layer));
+    }
+}
+
+void QuantizedNet::feedForward(const Layer &layer, const float *inputs, float *outputs, Workspace &workspace) {
+    // the range of this sample's inputs, widened to include 0 so that zero inputs stay exact
+    float lo = 0.0f;
+    float hi = 0.0f;
+    for (std::size_t i = 0; i < layer.numInputs; ++i) {
+        lo = std::min(lo, inputs[i]);
+        hi = std::max(hi, inputs[i]);
+    }
+    const float scale = hi > lo ? (hi - lo) / maxInput : 1.0f;
+    const float invScale = 1.0f / scale;
+    const float zeroPoint = std::round(-lo * invScale);
+
+    // x ~= scale * (q - zeroPoint); the padding stays 0 and meets zero weights. q is clamped to
+    // [0, 127] before rounding, so adding 0.5 and truncating rounds it (and vectorizes, unlike round)
+    workspace.quantized.resize(layer.stride);
+    std::uint8_t *quantized = workspace.quantized.data();
+    for (std::size_t i = 0; i < layer.numInputs; ++i) {
+        const float q = std::clamp(inputs[i] * invScale + zeroPoint, 0.0f, maxInput);
+        quantized[i] = static_cast<std::uint8_t>(q + 0.5f);
+    }
+    std::fill(quantized + layer.numInputs, quantized + layer.stride, std::uint8_t(0));
+
+    workspace.sums.resize(layer.numOutputs);
+    kernels::gemvU8S8(layer.numOutputs, layer.stride, layer.weights.data(), layer.stride,
+                      workspace.quantized.data(), workspace.sums.data());
+
+    // sum_i w_i * x_i ~= weightScale * scale * (sum_i qw_i * qx_i - zeroPoint * sum_i qw_i)
+    const auto zero = static_cast<std::int32_t>(zeroPoint);
+    for (std::size_t o = 0; o < layer.numOutputs; ++o) {
+        const std::int32_t sum = workspace.sums[o] - zero * layer.rowSums[o];
+        outputs[o] = layer.weightScales[o] * scale * static_cast<float>(sum);
+    }
+    kernels::biasActivate(layer.activation, 1, layer.numOutputs, layer.biases.data(), outputs);
+}
+
+void QuantizedNet::predict(const float *inputs, const std::size_t batchSize, float *outputs,
+                           Workspace &workspace) const {
+    const std::size_t numLayers = m_layers.size();
+    const std::size_t numInputs = getInputCount();
+    const std::size_t numOutputs = getOutputCount();
+
+    // the samples go through one by one: the inputs of every sample get their own scale
+    for (std::size_t b = 0; b < batchSize; ++b) {
+        const float *prevOutputs = inputs + b * numInputs;
+        for (std::size_t l = 0; l < numLayers; ++l) {
+            const Layer &layer = m_layers[l];
+            float *layerOutputs = outputs + b * numOutputs;
+            if (l + 1 < numLayers) {
+                std::vector<float> &buffer = workspace.activations[l % 2];
+                buffer.resize(layer.numOutputs);
+                layerOutputs = buffer.data();
+            }
+            feedForward(layer, prevOutputs, layerOutputs, workspace);
+            prevOutputs = layerOutputs;
+        }
+    }
+}
+
+void QuantizedNet::predict(const float *inputs, const std::size_t batchSize, float *outputs) const {
+    thread_local Workspace workspace;
+    predict(inputs, batchSize, outputs, workspace);
+}
+
+std::vector<double> QuantizedNet::predict(const std::vector<double> &inputValues) const {
+    assert(inputValues.size() == getInputCount());
+    const std::vector<float> inputs(inputValues.begin(), inputValues.end());
+    std::vector<float> outputs(getOutputCount());
+    predict(inputs.data(), 1, outputs.data());
+    return {outputs.begin(), outputs.end()};
+}
+
+std::vector<unsigned> QuantizedNet::getTopology() const {
+    std::vector<unsigned> topology{static_cast<unsigned>(getInputCount())};
+    for (const Layer &layer : m_layers) {
+        topology.push_back(static_cast<unsigned>(layer.numOutputs));
+    }
+    return topology;
+}
+
+std::size_t QuantizedNet::getParameterBytes() const {
+    std::size_t bytes = 0;
+    for (const Layer &layer : m_layers) {
+        bytes += layer.weights.size() * sizeof(std::int8_t) + layer.weightScales.size() * sizeof(float)
+                 + layer.rowSums.size() * sizeof(std::int32_t) + layer.biases.size() * sizeof(float);
+    }
+    return bytes;
+}
+
+template QuantizedNet::QuantizedNet(const BasicNet<float> &);
+template QuantizedNet::QuantizedNet(const BasicNet<double> &);
@@ -0,0 +1,76 @@
+//
+// Int8 inference on a copy of a trained net.
+//
+
+#ifndef XORGATE_NEURALNETWORK_QUANTIZEDNET_H
+#define XORGATE_NEURALNETWORK_QUANTIZEDNET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Activation.h"
+#include "Net.h"
+
+// A QuantizedNet holds the weights of a trained net as int8, a quarter of the float size (an
+// eighth of double), so the weights of small nets stay in L1/L2 while predicting.
+//
+// Every weight row (one output neuron) is quantized symmetrically with its own scale:
+// w ~= weightScale * q, q in [-127, 127]. The inputs of every layer are quantized per sample with
+// a scale and zero point covering their range: x ~= inputScale * (q - zeroPoint), q in [0, 127],
+// so the dot products run as an integer GEMV (kernels::gemvU8S8) with exact int32 sums. Each
+// layer dequantizes its sums to float before adding the biases and applying the transfer
+// function, which keeps the nonlinearities in float.
+//
+// Inputs are limited to 7 bits so that the AVX2 path (pmaddubsw, which saturates at 16 bits)
+// cannot overflow; with that, every kernel computes the same integer sums.
+//
+// The per-sample quantization costs a pass over every layer's inputs, so tiny nets (like the
+// 64-32-10 digits net) predict faster in float; the int8 path pays off once the weights no
+// longer fit the caches, e.g. about 5x for 1024-wide layers.
+class QuantizedNet {
+public:
+    // Scratch buffers of predict; every thread that predicts concurrently needs its own
+    struct Workspace {
+        std::vector<float> activations[2]; // outputs of the previous and the current layer
+        std::vector<std::uint8_t> quantized;
+        std::vector<std::int32_t> sums;
+    };
+
+    // quantizes the current parameters of net, which is not referenced afterwards
+    template<typename T>
+    explicit QuantizedNet(const BasicNet<T> &net);
+
+    // runs batchSize samples (row-major) through the net and writes the output values to
+    // outputs[batchSize x getOutputCount()]; const and thread-safe like Net::predict
+    void predict(const float *inputs, std::size_t batchSize, float *outputs, Workspace &workspace) const;
+    // the same, using a workspace owned by the calling thread
+    void predict(const float *inputs, std::size_t batchSize, float *outputs) const;
+    [[nodiscard]] std::vector<double> predict(const std::vector<double> &inputValues) const;
+
+    [[nodiscard]] std::vector<unsigned> getTopology() const;
+    [[nodiscard]] std::size_t getInputCount() const { return m_layers.front().numInputs; }
+    [[nodiscard]] std::size_t getOutputCount() const { return m_layers.back().numOutputs; }
+
+    // bytes of the quantized weights, scales and biases (padding included)
+    [[nodiscard]] std::size_t getParameterBytes() const;
+
+private:
+    struct Layer {
+        std::size_t numInputs;
+        std::size_t numOutputs;
+        std::size_t stride; // numInputs rounded up to the 64-byte blocks of gemvU8S8
+        Activation activation;
+        std::vector<std::int8_t> weights;  // [numOutputs x stride], row-major, zero padded
+        std::vector<float> weightScales;   // [numOutputs]
+        std::vector<std::int32_t> rowSums; // [numOutputs], sum of each weight row, for the zero point
+        std::vector<float> biases;         // [numOutputs], not quantized
+    };
+
+    // one sample of one layer: outputs[numOutputs] from inputs[numInputs]
+    static void feedForward(const Layer &layer, const float *inputs, float *outputs, Workspace &workspace);
+
+    std::vector<Layer> m_layers;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_QUANTIZEDNET_H
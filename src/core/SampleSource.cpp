@@ -0,0 +1,27 @@
+//
+// Anything that can hand out batches of training samples.
+//
+
+#include "SampleSource.h"
+#include <random>
+#include <utility>
+
+void SampleSource::sampleOrder(std::vector<std::size_t> &order, const bool shuffle, const std::uint64_t seed,
+                               const std::size_t epoch) const {
+    const std::size_t sampleCount = getSampleCount();
+    order.resize(sampleCount);
+    for (std::size_t i = 0; i < sampleCount; ++i) {
+        order[i] = i;
+    }
+    if (!shuffle) {
+        return;
+    }
+
+    // Fisher-Yates with mt19937_64, whose output the standard fixes (std::shuffle's is not);
+    // the modulo bias is below 2^-40 for any realistic sample count
+    std::mt19937_64 rng(seed ^ (0x9E3779B97F4A7C15ull * (epoch + 1)));
+    for (std::size_t i = sampleCount; i > 1; --i) {
+        const auto j = static_cast<std::size_t>(rng() % i);
+        std::swap(order[i - 1], order[j]);
+    }
+}
@@ -0,0 +1,34 @@
+//
+// Anything that can hand out batches of training samples.
+//
+
+#ifndef XORGATE_NEURALNETWORK_SAMPLESOURCE_H
+#define XORGATE_NEURALNETWORK_SAMPLESOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A SampleSource is the data side of training: a fixed number of samples, each with
+// getInputCount() inputs and getTargetCount() targets, that Trainer and HogwildTrainer copy
+// into float batches with gatherBatch. Dataset holds the samples in memory; BinaryDataset reads
+// them straight from its memory mapping. gatherBatch has to be safe to call from several
+// threads at once.
+class SampleSource {
+public:
+    virtual ~SampleSource() = default;
+
+    [[nodiscard]] virtual std::size_t getSampleCount() const = 0;
+    [[nodiscard]] virtual std::size_t getInputCount() const = 0;
+    [[nodiscard]] virtual std::size_t getTargetCount() const = 0;
+
+    // copies the samples indices[0..count) into contiguous row-major inputs/targets buffers
+    virtual void gatherBatch(const std::size_t *indices, std::size_t count, float *inputs, float *targets) const = 0;
+
+    // Fills order with the sample indices of one epoch: a random permutation that only depends on
+    // seed and epoch (the same on every platform), or file order if shuffle is false.
+    void sampleOrder(std::vector<std::size_t> &order, bool shuffle, std::uint64_t seed, std::size_t epoch) const;
+};
+
+
+#endif //XORGATE_NEURALNETWORK_SAMPLESOURCE_H
@@ -0,0 +1,62 @@
+//
+// Lock-free ring buffer between one producer and one consumer thread.
+//
+
+#ifndef XORGATE_NEURALNETWORK_SPSCRING_H
+#define XORGATE_NEURALNETWORK_SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// A SpscRing passes values of T from exactly one producer thread to exactly one consumer thread
+// without locks or allocation. Neither side ever waits: push fails when the ring is full, so a
+// slow consumer costs the producer dropped values, never time. Capacity must be a power of two;
+// the ring holds up to Capacity values.
+//
+// The producer only writes m_tail and the consumer only writes m_head; each index sits on its
+// own cache line so the two threads do not invalidate each other's line on every call.
+template<typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "the capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "values are copied in and out of the slots");
+
+public:
+    // producer: appends value, or returns false if the ring is full
+    bool push(const T &value) {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_slots[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer: takes the oldest value, or returns false if the ring is empty
+    bool pop(T &value) {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = m_slots[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // values waiting; exact only on the consumer side with no push in flight
+    [[nodiscard]] std::size_t size() const {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t cacheLine = 64;
+
+    alignas(cacheLine) std::atomic<std::size_t> m_head{0}; // next slot to read
+    alignas(cacheLine) std::atomic<std::size_t> m_tail{0}; // next slot to write
+    alignas(cacheLine) std::array<T, Capacity> m_slots{};
+};
+
+
+#endif //XORGATE_NEURALNETWORK_SPSCRING_H
@@ -0,0 +1,64 @@
+//
+// Metrics a running training publishes for live display.
+//
+
+#include "Telemetry.h"
+#include <algorithm>
+#include <cmath>
+
+TelemetrySample TelemetrySample::fromProgress(const TrainingProgress &progress, const std::size_t samplesPerEpoch) {
+    TelemetrySample sample;
+    sample.epoch = progress.epoch;
+    sample.epochCount = progress.epochCount;
+    sample.samples = progress.samples;
+    sample.epochs = samplesPerEpoch > 0
+        ? static_cast<double>(progress.samples) / static_cast<double>(samplesPerEpoch)
+        : static_cast<double>(progress.epoch);
+    sample.seconds = progress.seconds;
+    sample.error = progress.error;
+    sample.validationError = progress.validationError;
+    sample.learningRate = progress.learningRate;
+    sample.samplesPerSecond = progress.samplesPerSecond();
+    return sample;
+}
+
+template<typename T>
+GradientProbe<T>::GradientProbe(const SampleSource &samples, const std::size_t sampleCount, const double budget)
+    : m_count(std::min(sampleCount, samples.getSampleCount()))
+    , m_budget(budget)
+    , m_inputs(m_count * samples.getInputCount())
+    , m_targets(m_count * samples.getTargetCount())
+{
+    std::vector<std::size_t> indices(m_count);
+    for (std::size_t i = 0; i < m_count; ++i) {
+        indices[i] = i * samples.getSampleCount() / m_count;
+    }
+    samples.gatherBatch(indices.data(), m_count, m_inputs.data(), m_targets.data());
+    m_workspace.recordProfile = false; // probe passes are not training time
+}
+
+template<typename T>
+void GradientProbe<T>::measure(const BasicNet<T> &net, TelemetrySample &sample) {
+    const std::size_t layerCount = std::min(net.getLayerCount() - 1, maxTelemetryLayers);
+    sample.layerCount = layerCount;
+    const Clock::time_point start = Clock::now();
+    if (m_count > 0 && start >= m_nextMeasurement) {
+        net.computeGradients(m_inputs.data(), m_targets.data(), m_count, T(1) / static_cast<T>(m_count), m_workspace);
+        for (std::size_t l = 0; l < layerCount; ++l) {
+            double sum = 0.0;
+            for (const T gradient : m_workspace.weightGradients[l]) {
+                sum += static_cast<double>(gradient) * static_cast<double>(gradient);
+            }
+            for (const T gradient : m_workspace.biasGradients[l]) {
+                sum += static_cast<double>(gradient) * static_cast<double>(gradient);
+            }
+            m_norms[l] = std::sqrt(sum);
+        }
+        const Clock::time_point end = Clock::now();
+        m_nextMeasurement = end + std::chrono::duration_cast<Clock::duration>((end - start) / m_budget);
+    }
+    sample.gradientNorms = m_norms;
+}
+
+template class GradientProbe<float>;
+template class GradientProbe<double>;
@@ -0,0 +1,78 @@
+//
+// Metrics a running training publishes for live display.
+//
+
+#ifndef XORGATE_NEURALNETWORK_TELEMETRY_H
+#define XORGATE_NEURALNETWORK_TELEMETRY_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Net.h"
+#include "SampleSource.h"
+#include "SpscRing.h"
+#include "Trainer.h"
+
+// layers whose gradient norms a sample carries; deeper nets report their first ones
+inline constexpr std::size_t maxTelemetryLayers = 16;
+
+// One measurement of a running training, small and trivially copyable so it can go through a
+// TelemetryRing. The fields follow TrainingProgress.
+struct TelemetrySample {
+    std::size_t epoch = 0;
+    std::size_t epochCount = 0;
+    std::uint64_t samples = 0;
+    double epochs = 0.0; // epochs trained so far, with the current one as a fraction
+    double seconds = 0.0;
+    double error = 0.0;
+    double validationError = 0.0;
+    double learningRate = 0.0;
+    double samplesPerSecond = 0.0;
+    std::size_t layerCount = 0; // valid entries of gradientNorms
+    std::array<double, maxTelemetryLayers> gradientNorms{}; // L2 norm of every dense layer's gradient
+
+    // everything but the gradient norms (see GradientProbe); samplesPerEpoch gives epochs
+    static TelemetrySample fromProgress(const TrainingProgress &progress, std::size_t samplesPerEpoch);
+};
+
+// The training thread pushes samples from its progress callback, the UI thread pops them; full
+// means the UI has fallen behind by a thousand samples and new ones are dropped.
+using TelemetryRing = SpscRing<TelemetrySample, 1024>;
+
+// A GradientProbe measures how large the gradients of every layer currently are, on a fixed set
+// of samples taken once from the training data, so successive measurements are comparable. It
+// only reads the net (computeGradients), stays out of its profile and allocates nothing after
+// the first measurement.
+// A measurement costs a batch of the probe samples, which adds up on large nets, so the probe
+// keeps its share of the wall time under budget and repeats the last norms until it may measure
+// again.
+template<typename T>
+class GradientProbe {
+public:
+    // takes up to sampleCount samples spread evenly over samples (files may be sorted by label)
+    explicit GradientProbe(const SampleSource &samples, std::size_t sampleCount = 32, double budget = 0.02);
+
+    // writes the L2 norm of the mean weight and bias gradient of every dense layer of net over the
+    // probe samples to sample.gradientNorms and sets sample.layerCount; must not run while
+    // another thread updates net
+    void measure(const BasicNet<T> &net, TelemetrySample &sample);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t m_count;
+    double m_budget;
+    std::vector<float> m_inputs;
+    std::vector<float> m_targets;
+    typename BasicNet<T>::Workspace m_workspace;
+    std::array<double, maxTelemetryLayers> m_norms{};
+    Clock::time_point m_nextMeasurement; // measurements before it would exceed the budget
+};
+
+extern template class GradientProbe<float>;
+extern template class GradientProbe<double>;
+
+
+#endif //XORGATE_NEURALNETWORK_TELEMETRY_H
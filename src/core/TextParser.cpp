@@ -0,0 +1,180 @@
+//
+// Parser for the text training data format (topology:/in:/out: lines).
+//
+
+#include "TextParser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// below this, a chunk is not worth starting a thread for
+constexpr std::size_t minChunkSize = std::size_t(1) << 20;
+
+bool isSpace(const char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char *skipSpace(const char *p, const char *end) {
+    while (p != end && isSpace(*p)) ++p;
+    return p;
+}
+
+std::string_view takeWord(const char *&p, const char *end) {
+    p = skipSpace(p, end);
+    const char *start = p;
+    while (p != end && !isSpace(*p)) ++p;
+    return {start, static_cast<std::size_t>(p - start)};
+}
+
+// false if the next word is not a number; like operator>>, a leading '+' is allowed
+template<typename T>
+bool takeNumber(const char *&p, const char *end, T &value) {
+    const char *start = skipSpace(p, end);
+    if (start != end && *start == '+' && start + 1 != end && start[1] != '-') ++start;
+    const auto [ptr, ec] = std::from_chars(start, end, value);
+    if (ec != std::errc()) return false;
+    p = ptr;
+    return true;
+}
+
+bool startsWithWord(const std::string_view line, const std::string_view word) {
+    const char *p = line.data();
+    return takeWord(p, p + line.size()) == word;
+}
+
+// Reads samples until parser reaches stop or a line that does not continue them; parser is then
+// left after the last complete sample.
+std::size_t readChunk(TextParser &parser, const char *stop, const std::size_t inputCount, const std::size_t targetCount,
+                      std::vector<float> &inputs, std::vector<float> &targets) {
+    std::size_t samples = 0;
+    while (parser.position() < stop) {
+        TextParser sample = parser;
+        const std::size_t inputSize = inputs.size();
+        const std::size_t targetSize = targets.size();
+        if (sample.readValues("in:", inputs) != inputCount || sample.readValues("out:", targets) != targetCount) {
+            inputs.resize(inputSize);
+            targets.resize(targetSize);
+            break;
+        }
+        parser = sample;
+        ++samples;
+    }
+    return samples;
+}
+
+}
+
+std::string_view TextParser::nextLine() {
+    if (m_position == m_end) return {};
+    const auto *newline = static_cast<const char *>(
+        std::memchr(m_position, '\n', static_cast<std::size_t>(m_end - m_position)));
+    const char *lineEnd = newline ? newline : m_end;
+    const std::string_view line(m_position, static_cast<std::size_t>(lineEnd - m_position));
+    m_position = newline ? newline + 1 : m_end;
+    return line;
+}
+
+void TextParser::readTopology(std::vector<unsigned> &topology) {
+    topology.clear();
+    const std::string_view line = nextLine();
+    const char *p = line.data();
+    const char *end = p + line.size();
+    if (takeWord(p, end) != "topology:") return;
+    unsigned n;
+    while (takeNumber(p, end, n)) {
+        topology.push_back(n);
+    }
+}
+
+template<typename T>
+std::size_t TextParser::readValues(const std::string_view label, std::vector<T> &values) {
+    const std::string_view line = nextLine();
+    const char *p = line.data();
+    const char *end = p + line.size();
+    if (takeWord(p, end) != label) return 0;
+    // parsed as double and then narrowed, as the stream did
+    const std::size_t size = values.size();
+    double value;
+    while (takeNumber(p, end, value)) {
+        values.push_back(static_cast<T>(value));
+    }
+    return values.size() - size;
+}
+
+template std::size_t TextParser::readValues(std::string_view, std::vector<float> &);
+template std::size_t TextParser::readValues(std::string_view, std::vector<double> &);
+
+std::size_t TextParser::readSamples(const std::size_t inputCount, const std::size_t targetCount,
+                                    std::vector<float> &inputs, std::vector<float> &targets, unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const auto size = static_cast<std::size_t>(m_end - m_position);
+    // an empty out: line would let a sample end past the in: line a chunk starts at
+    const std::size_t chunkCount = inputCount == 0 || targetCount == 0
+        ? 1 : std::clamp<std::size_t>(size / minChunkSize, 1, threadCount);
+    if (chunkCount == 1) {
+        return readChunk(*this, m_end, inputCount, targetCount, inputs, targets);
+    }
+
+    // chunk c covers [bounds[c], bounds[c + 1]); the inner bounds are starts of in: lines, so a
+    // chunk reads the same samples the one before it would have continued with
+    std::vector<const char *> bounds{m_position};
+    for (std::size_t c = 1; c < chunkCount; ++c) {
+        TextParser scan(std::max(bounds.back(), m_position + c * size / chunkCount), m_end);
+        scan.nextLine(); // the rest of the line the cut fell into
+        while (!scan.atEnd()) {
+            TextParser peek = scan;
+            if (startsWithWord(peek.nextLine(), "in:")) break;
+            scan = peek;
+        }
+        bounds.push_back(scan.position());
+    }
+    bounds.push_back(m_end);
+
+    struct Chunk {
+        std::vector<float> inputs;
+        std::vector<float> targets;
+        std::size_t samples = 0;
+        const char *end = nullptr;
+    };
+    std::vector<Chunk> chunks(chunkCount);
+    const auto parse = [&](const std::size_t c) {
+        TextParser parser(bounds[c], m_end);
+        chunks[c].samples = readChunk(parser, bounds[c + 1], inputCount, targetCount, chunks[c].inputs, chunks[c].targets);
+        chunks[c].end = parser.position();
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(chunkCount - 1);
+    for (std::size_t c = 1; c < chunkCount; ++c) {
+        threads.emplace_back(parse, c);
+    }
+    parse(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // the samples end in the first chunk that stopped early; what follows it is not read
+    std::size_t used = 0;
+    std::size_t inputValues = 0;
+    std::size_t targetValues = 0;
+    while (used < chunkCount) {
+        const Chunk &chunk = chunks[used];
+        inputValues += chunk.inputs.size();
+        targetValues += chunk.targets.size();
+        if (chunk.end != bounds[++used]) break;
+    }
+    inputs.reserve(inputs.size() + inputValues);
+    targets.reserve(targets.size() + targetValues);
+    std::size_t samples = 0;
+    for (std::size_t c = 0; c < used; ++c) {
+        inputs.insert(inputs.end(), chunks[c].inputs.begin(), chunks[c].inputs.end());
+        targets.insert(targets.end(), chunks[c].targets.begin(), chunks[c].targets.end());
+        samples += chunks[c].samples;
+        m_position = chunks[c].end;
+    }
+    return samples;
+}
@@ -0,0 +1,55 @@
+//
+// Parser for the text training data format (topology:/in:/out: lines).
+//
+
+#ifndef XORGATE_NEURALNETWORK_TEXTPARSER_H
+#define XORGATE_NEURALNETWORK_TEXTPARSER_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// A TextParser reads lines in place from a buffer, usually a MappedFile, with std::from_chars
+// instead of a stringstream per line. Like the stream based reader it replaces, a line counts if
+// its first word is the expected label; the numbers after it are read up to the first word that
+// is not one.
+//
+//   topology: 2 4 1
+//   in: 1.0 0.0
+//   out: 1.0
+class TextParser {
+public:
+    TextParser(const char *begin, const char *end) : m_position(begin), m_end(end) {}
+
+    [[nodiscard]] const char *position() const { return m_position; }
+    [[nodiscard]] bool atEnd() const { return m_position == m_end; }
+
+    // reads the next line; fills topology with its layer sizes if it is a topology: line
+    void readTopology(std::vector<unsigned> &topology);
+
+    // reads the next line; if its first word is label, appends its numbers to values and
+    // returns how many there were, otherwise returns 0
+    template<typename T>
+    std::size_t readValues(std::string_view label, std::vector<T> &values);
+
+    // Reads samples (an in: line with inputCount numbers followed by an out: line with
+    // targetCount numbers) up to the first line that is not one, appending them row-major to
+    // inputs and targets; returns the number of samples. Large buffers are cut into chunks at in:
+    // lines and parsed on threadCount threads (0: one per hardware thread); the result is the same
+    // as reading sample by sample.
+    std::size_t readSamples(std::size_t inputCount, std::size_t targetCount,
+                            std::vector<float> &inputs, std::vector<float> &targets, unsigned threadCount = 0);
+
+private:
+    // the current line without its '\n'; moves past it
+    std::string_view nextLine();
+
+    const char *m_position;
+    const char *m_end;
+};
+
+extern template std::size_t TextParser::readValues(std::string_view, std::vector<float> &);
+extern template std::size_t TextParser::readValues(std::string_view, std::vector<double> &);
+
+
+#endif //XORGATE_NEURALNETWORK_TEXTPARSER_H
@@ -0,0 +1,170 @@
+//
+// Epoch loop shared by every front end: batches, schedules, early stopping and progress.
+//
+
+#include "Trainer.h"
+#include "EarlyStopping.h"
+#include "HogwildTrainer.h"
+#include "ParallelTrainer.h"
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// samples between two looks at the clock; reading it after every sample of a small net would
+// cost a noticeable share of the training time
+constexpr std::uint64_t clockCheckSamples = 1024;
+
+double secondsBetween(const Clock::time_point start, const Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+Trainer::Trainer(const TrainingOptions &options)
+    : m_options(options)
+{
+}
+
+template<typename T>
+TrainingResult Trainer::train(BasicNet<T> &net, const SampleSource &training, const SampleSource *validation,
+                              const std::atomic<bool> *cancel) {
+    assert(training.getInputCount() == net.getInputCount() && training.getTargetCount() == net.getOutputCount());
+    const std::size_t batchSize = std::max<std::size_t>(1, m_options.batchSize);
+    const bool validate = validation != nullptr && validation->getSampleCount() > 0;
+    const Optimizer optimizer = net.getOptimizer();
+    EarlyStopping<T> stopping(m_options.patience, m_options.minDelta);
+
+    TrainingResult result;
+    TrainingProgress &progress = result.progress;
+    progress.epochCount = m_options.epochs;
+    progress.learningRate = optimizer.learningRate;
+    const Clock::time_point start = Clock::now();
+    Clock::time_point lastCallback = start;
+
+    // refreshes the snapshot and reports it if a callback is due
+    const auto report = [&](const bool force) {
+        const Clock::time_point now = Clock::now();
+        progress.seconds = secondsBetween(start, now);
+        progress.error = net.getRecentAverageError();
+        publish(progress);
+        if (m_progressCallback && (force || now - lastCallback >= m_options.progressInterval)) {
+            lastCallback = now;
+            m_progressCallback(progress);
+        }
+    };
+    report(false);
+
+    std::optional<ParallelTrainer> parallel;
+    std::optional<HogwildTrainer> hogwild;
+    if (m_options.hogwild) {
+        hogwild.emplace(m_options.threadCount);
+    } else {
+        parallel.emplace(m_options.threadCount);
+    }
+    std::vector<std::size_t> order;
+    std::vector<float> inputs(hogwild ? 0 : batchSize * training.getInputCount());
+    std::vector<float> targets(hogwild ? 0 : batchSize * training.getTargetCount());
+    std::uint64_t samplesSinceCheck = 0;
+
+    for (std::size_t epoch = 0; epoch < m_options.epochs && !result.stoppedEarly; ++epoch) {
+        const Clock::time_point epochStart = Clock::now();
+        Optimizer scheduled = optimizer;
+        scheduled.learningRate *= m_options.schedule.factor(epoch, m_options.epochs);
+        net.setOptimizer(scheduled);
+        progress.learningRate = scheduled.learningRate;
+
+        training.sampleOrder(order, m_options.shuffle, m_options.seed, epoch);
+        if (hogwild) {
+            result.cancelled = !hogwild->trainEpoch(net, training, order, batchSize, cancel);
+            if (!result.cancelled) {
+                progress.samples += order.size();
+            }
+        } else {
+            for (std::size_t first = 0; first < order.size(); first += batchSize) {
+                if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) {
+                    result.cancelled = true;
+                    break;
+                }
+                const std::size_t count = std::min(batchSize, order.size() - first);
+                training.gatherBatch(order.data() + first, count, inputs.data(), targets.data());
+                parallel->trainBatch(net, inputs.data(), targets.data(), count);
+                progress.samples += count;
+                samplesSinceCheck += count;
+                if (samplesSinceCheck >= clockCheckSamples) {
+                    samplesSinceCheck = 0;
+                    report(false);
+                }
+            }
+        }
+        if (result.cancelled) {
+            break;
+        }
+
+        ++progress.epoch;
+        progress.epochSeconds = secondsBetween(epochStart, Clock::now());
+        if (validate) {
+            progress.validationError = validationError(net, *validation);
+            result.stoppedEarly = stopping.update(net, progress.validationError);
+        }
+        report(false);
+        if (m_epochCallback) {
+            m_epochCallback(progress);
+        }
+    }
+
+    // keep the parameters of the best epoch, and the learning rate the net came with
+    if (validate) {
+        result.restoredBest = stopping.restoreBest(net);
+        result.bestEpoch = stopping.getEpochCount() > 0 ? stopping.getBestEpoch() + 1 : 0;
+        result.bestValidationError = stopping.getBestError();
+    }
+    net.setOptimizer(optimizer);
+    progress.learningRate = optimizer.learningRate;
+    report(true);
+    return result;
+}
+
+TrainingProgress Trainer::getProgress() const {
+    TrainingProgress progress;
+    std::uint64_t before;
+    std::uint64_t after;
+    do {
+        before = m_sequence.load(std::memory_order_acquire);
+        progress.epoch = m_epoch.load(std::memory_order_relaxed);
+        progress.epochCount = m_epochCount.load(std::memory_order_relaxed);
+        progress.samples = m_samples.load(std::memory_order_relaxed);
+        progress.error = m_error.load(std::memory_order_relaxed);
+        progress.validationError = m_validationError.load(std::memory_order_relaxed);
+        progress.learningRate = m_learningRate.load(std::memory_order_relaxed);
+        progress.seconds = m_seconds.load(std::memory_order_relaxed);
+        progress.epochSeconds = m_epochSeconds.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return progress;
+}
+
+void Trainer::publish(const TrainingProgress &progress) {
+    const std::uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_epoch.store(progress.epoch, std::memory_order_relaxed);
+    m_epochCount.store(progress.epochCount, std::memory_order_relaxed);
+    m_samples.store(progress.samples, std::memory_order_relaxed);
+    m_error.store(progress.error, std::memory_order_relaxed);
+    m_validationError.store(progress.validationError, std::memory_order_relaxed);
+    m_learningRate.store(progress.learningRate, std::memory_order_relaxed);
+    m_seconds.store(progress.seconds, std::memory_order_relaxed);
+    m_epochSeconds.store(progress.epochSeconds, std::memory_order_relaxed);
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template TrainingResult Trainer::train(BasicNet<float> &, const SampleSource &, const SampleSource *,
+                                       const std::atomic<bool> *);
+template TrainingResult Trainer::train(BasicNet<double> &, const SampleSource &, const SampleSource *,
+                                       const std::atomic<bool> *);
@@ -0,0 +1,113 @@
+//
+// Epoch loop shared by every front end: batches, schedules, early stopping and progress.
+//
+
+#ifndef XORGATE_NEURALNETWORK_TRAINER_H
+#define XORGATE_NEURALNETWORK_TRAINER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "LearningRateSchedule.h"
+#include "Net.h"
+#include "SampleSource.h"
+
+struct TrainingOptions {
+    std::size_t epochs = 1;
+    std::size_t batchSize = 1;
+    bool shuffle = true;         // a new sample order every epoch, from seed and the epoch number
+    std::uint64_t seed = 1;
+    unsigned threadCount = 1;    // 0 = one per hardware thread
+    bool hogwild = false;        // HogwildTrainer instead of ParallelTrainer, see there
+    LearningRateSchedule schedule;
+    std::size_t patience = 0;    // epochs without a lower validation error before stopping; 0 = never
+    double minDelta = 0.0;       // smallest decrease of the validation error that counts
+    std::chrono::milliseconds progressInterval{200}; // least time between two progress callbacks
+};
+
+// A snapshot of a running training.
+struct TrainingProgress {
+    std::size_t epoch = 0;          // epochs completed
+    std::size_t epochCount = 0;     // epochs planned
+    std::uint64_t samples = 0;      // samples trained, over all epochs
+    double error = 0.0;             // the net's recent average error
+    double validationError = 0.0;   // after the last completed epoch; 0 without validation samples
+    double learningRate = 0.0;      // of the current epoch
+    double seconds = 0.0;           // since training started
+    double epochSeconds = 0.0;      // duration of the last completed epoch
+
+    [[nodiscard]] double samplesPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(samples) / seconds : 0.0;
+    }
+};
+
+struct TrainingResult {
+    TrainingProgress progress;      // the final snapshot
+    bool cancelled = false;
+    bool stoppedEarly = false;      // patience ran out
+    bool restoredBest = false;      // the net was rolled back to its best epoch
+    std::size_t bestEpoch = 0;      // counting from 1; 0 without validation samples
+    double bestValidationError = 0.0;
+};
+
+// Trainer runs whole trainings: epoch after epoch over a SampleSource, in batches, on
+// ParallelTrainer's or HogwildTrainer's threads. Before every epoch it sets the learning rate the
+// schedule asks for; after it, it measures the error on the validation samples (if any) and stops
+// early once patience runs out, leaving the net with the parameters of its best epoch. The
+// optimizer's own learning rate is restored at the end. The CLI, the GUI and the benchmarks all
+// train through it.
+//
+// Progress is published as a TrainingProgress snapshot, at batch granularity in synchronous mode
+// and after every epoch in Hogwild mode. Any thread can read the latest snapshot with
+// getProgress, without locks and without slowing training down; callbacks run on the training
+// thread, so they should be quick.
+class Trainer {
+public:
+    using ProgressCallback = std::function<void(const TrainingProgress &)>;
+
+    explicit Trainer(const TrainingOptions &options = {});
+
+    Trainer(const Trainer &) = delete;
+    Trainer &operator=(const Trainer &) = delete;
+
+    [[nodiscard]] const TrainingOptions &getOptions() const { return m_options; }
+
+    // called at most every progressInterval, and once more when training ends
+    void setProgressCallback(ProgressCallback callback) { m_progressCallback = std::move(callback); }
+    // called after every completed epoch
+    void setEpochCallback(ProgressCallback callback) { m_epochCallback = std::move(callback); }
+
+    // Trains net on training; validation may be nullptr. Returns early, with cancelled set, once
+    // cancel (if given) becomes true; the net then keeps the updates made so far.
+    template<typename T>
+    TrainingResult train(BasicNet<T> &net, const SampleSource &training, const SampleSource *validation = nullptr,
+                         const std::atomic<bool> *cancel = nullptr);
+
+    // the latest snapshot; lock-free, safe to call from any thread while train runs
+    [[nodiscard]] TrainingProgress getProgress() const;
+
+private:
+    // writes the snapshot; only the training thread does
+    void publish(const TrainingProgress &progress);
+
+    TrainingOptions m_options;
+    ProgressCallback m_progressCallback;
+    ProgressCallback m_epochCallback;
+
+    // The snapshot behind a sequence lock: the counter is odd while the fields are written, and
+    // a reader retries until it saw the same even value before and after reading them.
+    std::atomic<std::uint64_t> m_sequence{0};
+    std::atomic<std::size_t> m_epoch{0};
+    std::atomic<std::size_t> m_epochCount{0};
+    std::atomic<std::uint64_t> m_samples{0};
+    std::atomic<double> m_error{0.0};
+    std::atomic<double> m_validationError{0.0};
+    std::atomic<double> m_learningRate{0.0};
+    std::atomic<double> m_seconds{0.0};
+    std::atomic<double> m_epochSeconds{0.0};
+};
+
+
+#endif //XORGATE_NEURALNETWORK_TRAINER_H
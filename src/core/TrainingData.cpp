@@ -3,63 +3,66 @@
 //
 
 #include "TrainingData.h"
+#include "BinaryDataset.h"
+#include "MappedFile.h"
 #include <vector>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <stdexcept>
 
-TrainingData::TrainingData(const std::string &filename) : m_filename(filename) {
-    m_trainingDataFile.open(filename.c_str());
-    if (!m_trainingDataFile.is_open()) {
+TrainingData::TrainingData(const std::string &filename) {
+    if (BinaryDataset::isBinaryDataset(filename)) {
+        m_binary = std::make_unique<BinaryDataset>(filename);
+        return;
+    }
+    try {
+        m_text = std::make_unique<MappedFile>(filename);
+    } catch (const std::runtime_error &) {
         std::cerr << "Error: training data file not found: " << filename << std::endl;
         throw std::runtime_error("Training data file not found");
     }
+    const auto *begin = reinterpret_cast<const char *>(m_text->data());
+    m_parser = TextParser(begin, begin + m_text->size());
 }
 
+TrainingData::~TrainingData() = default;
+
 bool TrainingData::peekTopology(const std::string &filename, std::vector<unsigned> &topology) {
     topology.clear();
+    if (BinaryDataset::isBinaryDataset(filename)) {
+        try {
+            topology = BinaryDataset(filename).getTopology();
+        } catch (const std::runtime_error &) {
+            return false;
+        }
+        return true;
+    }
     std::ifstream file(filename);
     if (!file.is_open()) return false;
     std::string line;
     if (!std::getline(file, line)) return false;
-    std::stringstream ss(line);
-    std::string label;
-    ss >> label;
-    if (label != "topology:") return false;
-    unsigned n;
-    while (ss >> n) topology.push_back(n);
+    TextParser(line.data(), line.data() + line.size()).readTopology(topology);
     return !topology.empty();
 }
 
 void TrainingData::reset() {
-    m_trainingDataFile.close();
-    m_trainingDataFile.open(m_filename);
-    if (!m_trainingDataFile.is_open()) {
-        throw std::runtime_error("Failed to reset training data file");
+    if (m_binary) {
+        m_nextSample = 0;
+        return;
     }
+    const auto *begin = reinterpret_cast<const char *>(m_text->data());
+    m_parser = TextParser(begin, begin + m_text->size());
     std::vector<unsigned> dummy;
     getTopology(dummy);
 }
 
 void TrainingData::getTopology(std::vector<unsigned> &topology) {
     topology.clear();
-    std::string line;
-    std::string label;
-
-    if (!std::getline(m_trainingDataFile, line)) {
+    if (m_binary) {
+        topology = m_binary->getTopology();
         return;
     }
-    std::stringstream ss(line);
-    ss >> label;
-
-    if (label != "topology:") {
-        return;
-    }
-    unsigned n;
-    while (ss >> n) {
-        topology.push_back(n);
-    }
+    m_parser.readTopology(topology);
 }
 
 bool TrainingData::isEof() {
@@ -68,37 +71,25 @@ bool TrainingData::isEof() {
 
 std::size_t TrainingData::getNextInputs(std::vector<double> &inputVals) {
     inputVals.clear();
-
-    std::string line;
-    getline(m_trainingDataFile, line);
-    std::stringstream ss(line);
-
-    std::string label;
-    ss >> label;
-    if (label.compare("in:") == 0) {
-        double oneValue;
-        while (ss >> oneValue) {
-            inputVals.push_back(oneValue);
+    if (m_binary) {
+        if (m_nextSample < m_binary->getSampleCount()) {
+            m_binary->getInputs(m_nextSample, inputVals);
         }
+        return inputVals.size();
     }
 
-    return inputVals.size();
+    return m_parser.readValues("in:", inputVals);
 }
 
 std::size_t TrainingData::getTargetOutputs(std::vector<double> &targetOutputVals) {
     targetOutputVals.clear();
-
-    std::string line;
-    std::getline(m_trainingDataFile, line);
-    std::stringstream ss(line);
-
-    std::string label;
-    ss >> label;
-    if (label.compare("out:") == 0) {
-        double oneValue;
-        while (ss >> oneValue) {
-            targetOutputVals.push_back(oneValue);
+    if (m_binary) {
+        // the targets complete a sample
+        if (m_nextSample < m_binary->getSampleCount()) {
+            m_binary->getTargets(m_nextSample++, targetOutputVals);
         }
+        return targetOutputVals.size();
     }
-    return targetOutputVals.size();
+
+    return m_parser.readValues("out:", targetOutputVals);
 }
@@ -7,14 +7,20 @@
 
 
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
-#include <fstream>
-#include <sstream>
+#include "TextParser.h"
 
+class BinaryDataset;
+class MappedFile;
+
+// Reads the text format (topology:/in:/out: lines) with a TextParser or, if the file starts with
+// the binary magic, a BinaryDataset; both are memory-mapped, so reset() only rewinds.
 class TrainingData {
 public:
     explicit TrainingData(const std::string &filename);
+    ~TrainingData();
 
     static bool isEof();
 
@@ -30,8 +36,10 @@ public:
     static bool peekTopology(const std::string &filename, std::vector<unsigned> &topology);
 
 private:
-    std::ifstream m_trainingDataFile;
-    std::string m_filename;
+    std::unique_ptr<MappedFile> m_text; // set for text files
+    TextParser m_parser{nullptr, nullptr};
+    std::unique_ptr<BinaryDataset> m_binary; // set for binary files, which bypass the text parsing
+    std::size_t m_nextSample = 0;
 };
 
 
@@ -2,13 +2,14 @@
 #include "DrawDigitWidget.h"
 #include "Net.h"
 #include <cstddef>
+#include <utility>
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QLabel>
 
-DrawDigitDialog::DrawDigitDialog(Net *net, QWidget *parent)
+DrawDigitDialog::DrawDigitDialog(std::shared_ptr<const Net> net, QWidget *parent)
     : QDialog(parent)
-    , m_net(net)
+    , m_net(std::move(net))
 {
     setWindowTitle(tr("Draw Digit"));
     setModal(false);
@@ -46,9 +47,7 @@ void DrawDigitDialog::onPredict() const {
     if (!m_net || m_net->getLayerCount() == 0) return;
     const auto vals = m_grid->getValues();
     if (vals.size() != 64) return;
-    m_net->feedForward(vals);
-    std::vector<double> results;
-    m_net->getResults(results);
+    const std::vector<double> results = m_net->predict(vals);
     std::size_t best = 0;
     for (std::size_t i = 1; i < results.size(); ++i) {
         if (results[i] > results[best]) best = i;
@@ -2,9 +2,12 @@
 #define DRAWDIGITDIALOG_H
 
 #include <QDialog>
+#include <memory>
 #include <vector>
 
-class Net;
+template<typename T>
+class BasicNet;
+using Net = BasicNet<double>;
 class DrawDigitWidget;
 class QLabel;
 
@@ -12,7 +15,8 @@ class DrawDigitDialog : public QDialog {
     Q_OBJECT
 
 public:
-    explicit DrawDigitDialog(Net *net, QWidget *parent = nullptr);
+    // net is a snapshot the dialog shares, so it stays valid while the main window trains or replaces its net
+    explicit DrawDigitDialog(std::shared_ptr<const Net> net, QWidget *parent = nullptr);
 
     std::vector<double> getDrawnValues() const;
 
@@ -24,7 +28,7 @@ private:
     void onApply();
     void onClear() const;
 
-    Net *m_net;
+    std::shared_ptr<const Net> m_net;
     DrawDigitWidget *m_grid;
     QLabel *m_resultLabel;
 };
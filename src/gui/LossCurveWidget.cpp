@@ -0,0 +1,138 @@
+#include "LossCurveWidget.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double LEFT_MARGIN = 56.0;
+constexpr double BOTTOM_MARGIN = 20.0;
+constexpr double MIN_ERROR = 1e-9; // the log axis needs positive values
+
+const QColor TRAINING_COLOR(40, 100, 200);
+const QColor VALIDATION_COLOR(230, 120, 20);
+
+double logError(const QPointF &point) {
+    return std::log10(std::max(point.y(), MIN_ERROR));
+}
+
+}
+
+LossCurveWidget::LossCurveWidget(QWidget *parent) : QWidget(parent) {
+    setMinimumHeight(120);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+}
+
+void LossCurveWidget::clear(const std::size_t epochCount) {
+    m_errors.clear();
+    m_validationErrors.clear();
+    m_epochCount = std::max(1.0, static_cast<double>(epochCount));
+    update();
+}
+
+void LossCurveWidget::addError(const double epoch, const double error) {
+    addPoint(m_errors, QPointF(epoch, error));
+    update();
+}
+
+void LossCurveWidget::addValidationError(const double epoch, const double error) {
+    addPoint(m_validationErrors, QPointF(epoch, error));
+    update();
+}
+
+QSize LossCurveWidget::sizeHint() const {
+    return {400, 180};
+}
+
+void LossCurveWidget::addPoint(QVector<QPointF> &series, const QPointF point) {
+    series.append(point);
+    if (series.size() <= MAX_POINTS) {
+        return;
+    }
+    // every other point, always keeping the newest
+    QVector<QPointF> halved;
+    halved.reserve(series.size() / 2 + 1);
+    for (qsizetype i = series.size() % 2 == 0 ? 1 : 0; i < series.size(); i += 2) {
+        halved.append(series[i]);
+    }
+    series = std::move(halved);
+}
+
+void LossCurveWidget::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.fillRect(rect(), Qt::white);
+    const QRectF plot = QRectF(rect()).adjusted(LEFT_MARGIN, 8, -8, -BOTTOM_MARGIN);
+    p.setPen(Qt::lightGray);
+    p.drawRect(plot);
+
+    if (m_errors.isEmpty() && m_validationErrors.isEmpty()) {
+        p.setPen(Qt::gray);
+        p.drawText(plot, Qt::AlignCenter, tr("The error curve appears here during training"));
+        return;
+    }
+
+    // the error axis spans both series, at least a tenth of a decade
+    double low = std::numeric_limits<double>::max();
+    double high = std::numeric_limits<double>::lowest();
+    for (const QVector<QPointF> *series : {&m_errors, &m_validationErrors}) {
+        for (const QPointF &point : *series) {
+            low = std::min(low, logError(point));
+            high = std::max(high, logError(point));
+        }
+    }
+    if (high - low < 0.1) {
+        const double middle = (high + low) / 2.0;
+        low = middle - 0.05;
+        high = middle + 0.05;
+    }
+    const auto toScreen = [&](const QPointF &point) {
+        const double x = std::min(point.x() / m_epochCount, 1.0);
+        const double y = (logError(point) - low) / (high - low);
+        return QPointF(plot.left() + x * plot.width(), plot.bottom() - y * plot.height());
+    };
+
+    p.setPen(Qt::darkGray);
+    const QRectF topLabel(0, plot.top() - 6, LEFT_MARGIN - 4, 12);
+    const QRectF bottomLabel(0, plot.bottom() - 6, LEFT_MARGIN - 4, 12);
+    p.drawText(topLabel, Qt::AlignRight | Qt::AlignVCenter, QString::number(std::pow(10.0, high), 'g', 3));
+    p.drawText(bottomLabel, Qt::AlignRight | Qt::AlignVCenter, QString::number(std::pow(10.0, low), 'g', 3));
+    const QRectF axis(plot.left(), plot.bottom() + 2, plot.width(), BOTTOM_MARGIN - 2);
+    p.drawText(axis, Qt::AlignLeft | Qt::AlignTop, QStringLiteral("0"));
+    p.drawText(axis, Qt::AlignHCenter | Qt::AlignTop, tr("epochs"));
+    p.drawText(axis, Qt::AlignRight | Qt::AlignTop, QString::number(m_epochCount, 'g', 6));
+
+    QPolygonF errors;
+    errors.reserve(m_errors.size());
+    for (const QPointF &point : m_errors) {
+        errors.append(toScreen(point));
+    }
+    p.setPen(QPen(TRAINING_COLOR, 1.5));
+    p.drawPolyline(errors);
+
+    // validation errors come once per epoch, so they get markers too
+    if (!m_validationErrors.isEmpty()) {
+        QPolygonF validation;
+        for (const QPointF &point : m_validationErrors) {
+            validation.append(toScreen(point));
+        }
+        p.setPen(QPen(VALIDATION_COLOR, 1.5));
+        p.drawPolyline(validation);
+        p.setBrush(VALIDATION_COLOR);
+        for (const QPointF &point : validation) {
+            p.drawEllipse(point, 2.5, 2.5);
+        }
+    }
+
+    // legend in the top right corner
+    const QRectF legend = plot.adjusted(0, 4, -6, 0);
+    p.setPen(TRAINING_COLOR);
+    p.drawText(legend, Qt::AlignRight | Qt::AlignTop, tr("training"));
+    if (!m_validationErrors.isEmpty()) {
+        p.setPen(VALIDATION_COLOR);
+        p.drawText(legend.adjusted(0, p.fontMetrics().height(), 0, 0), Qt::AlignRight | Qt::AlignTop, tr("validation"));
+    }
+}
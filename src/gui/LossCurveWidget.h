@@ -0,0 +1,37 @@
+#ifndef LOSSCURVEWIDGET_H
+#define LOSSCURVEWIDGET_H
+
+#include <QPointF>
+#include <QVector>
+#include <QWidget>
+#include <cstddef>
+
+// Plots the training error (and the validation error, if any) over the epochs of a running
+// training, on a logarithmic error axis.
+class LossCurveWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit LossCurveWidget(QWidget *parent = nullptr);
+
+    // starts a new plot whose epoch axis runs to epochCount
+    void clear(std::size_t epochCount);
+    void addError(double epoch, double error);
+    void addValidationError(double epoch, double error);
+
+    [[nodiscard]] QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    // halves a series once it gets longer than the widget could show anyway
+    static void addPoint(QVector<QPointF> &series, QPointF point);
+
+    static constexpr int MAX_POINTS = 4096;
+    QVector<QPointF> m_errors;
+    QVector<QPointF> m_validationErrors;
+    double m_epochCount = 1.0;
+};
+
+#endif // LOSSCURVEWIDGET_H
@@ -1,14 +1,20 @@
 #include "MainWindow.h"
 #include "DrawDigitDialog.h"
+#include "LossCurveWidget.h"
 #include "NetworkScene.h"
 #include "Net.h"
-#include "Neuron.h"
 #include "TrainingData.h"
+#include "Dataset.h"
+#include "Trainer.h"
 #include <QVBoxLayout>
 #include <QGroupBox>
 #include <QFormLayout>
 #include <QPushButton>
 #include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QListWidgetItem>
 #include <QLabel>
 #include <QFileDialog>
@@ -21,8 +27,16 @@
 #include <QApplication>
 #include <QTimer>
 #include <QMetaObject>
+#include <QStringList>
+#include <QMenuBar>
+#include <QMenu>
+#include <QAction>
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <optional>
 #include <thread>
+#include <utility>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -57,17 +71,29 @@ MainWindow::MainWindow(QWidget *parent)
 
     splitter->addWidget(leftScroll);
 
-    // Right panel: network visualization
+    // Right panel: network visualization above the live error curve
     setupNetworkView(m_centralWidget);
-    splitter->addWidget(m_networkView);
+    auto *rightSplitter = new QSplitter(Qt::Vertical);
+    rightSplitter->addWidget(m_networkView);
+    rightSplitter->addWidget(setupTelemetryPanel(rightSplitter));
+    rightSplitter->setStretchFactor(0, 3);
+    rightSplitter->setStretchFactor(1, 1);
+    splitter->addWidget(rightSplitter);
 
     splitter->setStretchFactor(0, 0);
     splitter->setStretchFactor(1, 1);
     m_mainLayout->addWidget(splitter);
 
+    setupMenus();
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow() {
+    // a running training uses the net and the samples this window owns
+    m_cancelTraining.store(true);
+    if (m_trainingThread.joinable()) {
+        m_trainingThread.join();
+    }
+}
 
 QWidget *MainWindow::setupTopologyPanel(QWidget *parent) {
     auto *group = new QGroupBox(tr("Topology"), parent);
@@ -119,10 +145,19 @@ QWidget *MainWindow::setupTrainingPanel(QWidget *parent) {
     m_epochsSpin->setSingleStep(10);
     paramsLayout->addRow(tr("Epochs:"), m_epochsSpin);
 
+    m_optimizerCombo = new QComboBox;
+    m_optimizerCombo->addItem(tr("SGD + momentum"), static_cast<int>(OptimizerType::Momentum));
+    m_optimizerCombo->addItem(tr("Nesterov"), static_cast<int>(OptimizerType::Nesterov));
+    m_optimizerCombo->addItem(tr("Adam"), static_cast<int>(OptimizerType::Adam));
+    m_optimizerCombo->addItem(tr("RMSProp"), static_cast<int>(OptimizerType::RMSProp));
+    m_optimizerCombo->setToolTip(tr("Adam and RMSProp adapt the step size of every weight; "
+                                    "they usually want a learning rate around 0.001"));
+    paramsLayout->addRow(tr("Optimizer:"), m_optimizerCombo);
+
     m_etaSpin = new QDoubleSpinBox;
-    m_etaSpin->setRange(0.001, 1.0);
+    m_etaSpin->setRange(0.0001, 1.0);
     m_etaSpin->setValue(0.1);
-    m_etaSpin->setDecimals(3);
+    m_etaSpin->setDecimals(4);
     m_etaSpin->setSingleStep(0.01);
     paramsLayout->addRow(tr("Learning rate (η):"), m_etaSpin);
 
@@ -131,8 +166,75 @@ QWidget *MainWindow::setupTrainingPanel(QWidget *parent) {
     m_alphaSpin->setValue(0.5);
     m_alphaSpin->setDecimals(3);
     m_alphaSpin->setSingleStep(0.05);
+    m_alphaSpin->setToolTip(tr("Used by SGD + momentum and Nesterov"));
     paramsLayout->addRow(tr("Momentum (α):"), m_alphaSpin);
 
+    m_scheduleCombo = new QComboBox;
+    m_scheduleCombo->addItem(tr("Constant"), static_cast<int>(ScheduleType::Constant));
+    m_scheduleCombo->addItem(tr("Step"), static_cast<int>(ScheduleType::Step));
+    m_scheduleCombo->addItem(tr("Cosine"), static_cast<int>(ScheduleType::Cosine));
+    m_scheduleCombo->setToolTip(tr("Step: the learning rate drops to a tenth after each third of the epochs.\n"
+                                   "Cosine: it decreases smoothly to 0 over all epochs."));
+    paramsLayout->addRow(tr("LR schedule:"), m_scheduleCombo);
+
+    m_warmupSpin = new QSpinBox;
+    m_warmupSpin->setRange(0, 1000);
+    m_warmupSpin->setValue(0);
+    m_warmupSpin->setToolTip(tr("Epochs over which the learning rate ramps up from a small value"));
+    paramsLayout->addRow(tr("Warmup epochs:"), m_warmupSpin);
+
+    m_validationSpin = new QSpinBox;
+    m_validationSpin->setRange(0, 50);
+    m_validationSpin->setValue(0);
+    m_validationSpin->setSuffix(tr(" %"));
+    m_validationSpin->setToolTip(tr("Samples held out of training to measure the error after every epoch (0 = none)"));
+    paramsLayout->addRow(tr("Validation:"), m_validationSpin);
+
+    m_patienceSpin = new QSpinBox;
+    m_patienceSpin->setRange(0, 100000);
+    m_patienceSpin->setValue(10);
+    m_patienceSpin->setToolTip(tr("Stop after this many epochs without a lower validation error (0 = never) "
+                                  "and keep the weights of the best epoch"));
+    m_patienceSpin->setEnabled(false);
+    connect(m_validationSpin, &QSpinBox::valueChanged, m_patienceSpin, [this](int value) {
+        m_patienceSpin->setEnabled(value > 0);
+    });
+    paramsLayout->addRow(tr("Patience:"), m_patienceSpin);
+
+    m_hiddenActivationCombo = new QComboBox;
+    m_outputActivationCombo = new QComboBox;
+    for (const Activation activation : {Activation::Tanh, Activation::Sigmoid, Activation::ReLU, Activation::Linear}) {
+        m_hiddenActivationCombo->addItem(QString::fromLatin1(activationName(activation)), static_cast<int>(activation));
+        m_outputActivationCombo->addItem(QString::fromLatin1(activationName(activation)), static_cast<int>(activation));
+    }
+    paramsLayout->addRow(tr("Hidden activation:"), m_hiddenActivationCombo);
+    paramsLayout->addRow(tr("Output activation:"), m_outputActivationCombo);
+
+    m_batchSpin = new QSpinBox;
+    m_batchSpin->setRange(1, 4096);
+    m_batchSpin->setValue(1);
+    m_batchSpin->setToolTip(tr("Samples per weight update (1 = update after every sample)"));
+    paramsLayout->addRow(tr("Batch size:"), m_batchSpin);
+
+    m_shuffleCheck = new QCheckBox(tr("Shuffle every epoch"));
+    m_shuffleCheck->setChecked(true);
+    m_shuffleCheck->setToolTip(tr("Needed for files sorted by label, e.g. digits.txt"));
+    paramsLayout->addRow(QString(), m_shuffleCheck);
+
+    m_threadsSpin = new QSpinBox;
+    m_threadsSpin->setRange(1, 256);
+    m_threadsSpin->setValue(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    m_threadsSpin->setToolTip(tr("Number of training threads"));
+    paramsLayout->addRow(tr("Threads:"), m_threadsSpin);
+
+    m_trainingModeCombo = new QComboBox;
+    m_trainingModeCombo->addItem(tr("Synchronous"));
+    m_trainingModeCombo->addItem(tr("Hogwild (asynchronous)"));
+    m_trainingModeCombo->setToolTip(tr("Synchronous: every batch is split across the threads and applied as one update.\n"
+                                       "Hogwild: every thread trains on its own part of the epoch and updates the "
+                                       "weights without waiting for the others."));
+    paramsLayout->addRow(tr("Mode:"), m_trainingModeCombo);
+
     m_trainButton = new QPushButton(tr("Train"));
     m_cancelButton = new QPushButton(tr("Cancel"));
     m_cancelButton->setEnabled(false);
@@ -197,18 +299,115 @@ void MainWindow::setupNetworkView(QWidget *parent) {
     m_networkView->setBackgroundBrush(QColor(245, 245, 250));
 }
 
+QWidget *MainWindow::setupTelemetryPanel(QWidget *parent) {
+    auto *panel = new QWidget(parent);
+    auto *layout = new QVBoxLayout(panel);
+    layout->setContentsMargins(0, 0, 0, 0);
+    m_lossCurve = new LossCurveWidget(panel);
+    m_gradientLabel = new QLabel(panel);
+    m_gradientLabel->setWordWrap(true);
+    m_gradientLabel->setToolTip(tr("Size of every layer's weight gradient on a fixed handful of training samples"));
+    layout->addWidget(m_lossCurve);
+    layout->addWidget(m_gradientLabel);
+
+    // the training thread never touches the widgets; it queues metrics that are picked up here
+    m_telemetryTimer = new QTimer(this);
+    m_telemetryTimer->setInterval(50);
+    connect(m_telemetryTimer, &QTimer::timeout, this, &MainWindow::onDrainTelemetry);
+    return panel;
+}
+
 void MainWindow::onBrowseTrainingData() {
     const QString path = QFileDialog::getOpenFileName(
         this,
         tr("Select Training Data"),
         QString(),
-        tr("Text files (*.txt);;All files (*)")
+        tr("Training data (*.txt *.bin);;All files (*)")
     );
     if (!path.isEmpty()) {
         m_trainingDataPath->setText(path);
     }
 }
 
+void MainWindow::setupMenus() {
+    QMenu *fileMenu = menuBar()->addMenu(tr("&File"));
+    QAction *openAction = fileMenu->addAction(tr("&Open Model..."));
+    openAction->setShortcut(QKeySequence::Open);
+    connect(openAction, &QAction::triggered, this, &MainWindow::onOpenModel);
+    QAction *saveAction = fileMenu->addAction(tr("&Save Model..."));
+    saveAction->setShortcut(QKeySequence::Save);
+    connect(saveAction, &QAction::triggered, this, &MainWindow::onSaveModel);
+    fileMenu->addSeparator();
+    QAction *quitAction = fileMenu->addAction(tr("&Quit"));
+    quitAction->setShortcut(QKeySequence::Quit);
+    connect(quitAction, &QAction::triggered, this, &QWidget::close);
+}
+
+void MainWindow::onOpenModel() {
+    if (m_trainingSnapshot) {
+        QMessageBox::information(this, tr("Open Model"), tr("Please wait for training to finish."));
+        return;
+    }
+    const QString path = QFileDialog::getOpenFileName(this, tr("Open Model"), QString(),
+                                                      tr("Models (*.nnm);;All files (*)"));
+    if (path.isEmpty()) return;
+    try {
+        m_net = std::make_unique<Net>(Net::load(path.toStdString()));
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, tr("Open Model"), QString::fromStdString(e.what()));
+        return;
+    }
+
+    // show the loaded network's topology and activations in the controls
+    m_topologyList->clear();
+    for (const unsigned n : m_net->getTopology()) {
+        auto *item = new QListWidgetItem(QString::number(n));
+        item->setFlags(item->flags() | Qt::ItemIsEditable);
+        m_topologyList->addItem(item);
+    }
+    const size_t layerCount = m_net->getLayerCount();
+    if (layerCount > 2) {
+        m_hiddenActivationCombo->setCurrentIndex(
+            m_hiddenActivationCombo->findData(static_cast<int>(m_net->getActivation(1))));
+    }
+    m_outputActivationCombo->setCurrentIndex(
+        m_outputActivationCombo->findData(static_cast<int>(m_net->getActivation(layerCount - 1))));
+    // and its optimizer, so Train continues with the settings it was saved with
+    const Optimizer &optimizer = m_net->getOptimizer();
+    m_optimizerCombo->setCurrentIndex(m_optimizerCombo->findData(static_cast<int>(optimizer.type)));
+    m_etaSpin->setValue(optimizer.learningRate);
+    if (optimizer.type == OptimizerType::Momentum || optimizer.type == OptimizerType::Nesterov) {
+        m_alphaSpin->setValue(optimizer.momentum);
+    }
+
+    refreshPredictInputs();
+    refreshNetworkVisualization();
+    m_statusLabel->setText(tr("Model loaded from %1").arg(QFileInfo(path).fileName()));
+}
+
+void MainWindow::onSaveModel() {
+    if (!m_net) {
+        QMessageBox::information(this, tr("Save Model"), tr("Please create or train a network first."));
+        return;
+    }
+    if (m_trainingSnapshot) {
+        QMessageBox::information(this, tr("Save Model"), tr("Please wait for training to finish."));
+        return;
+    }
+    QString path = QFileDialog::getSaveFileName(this, tr("Save Model"), QString(),
+                                                tr("Models (*.nnm);;All files (*)"));
+    if (path.isEmpty()) return;
+    if (QFileInfo(path).suffix().isEmpty()) {
+        path += QStringLiteral(".nnm");
+    }
+    try {
+        m_net->save(path.toStdString());
+        m_statusLabel->setText(tr("Model saved to %1").arg(QFileInfo(path).fileName()));
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, tr("Save Model"), QString::fromStdString(e.what()));
+    }
+}
+
 void MainWindow::onLoadTopologyFromFile() {
     const QString path = m_trainingDataPath->text().trimmed();
     if (path.isEmpty()) {
@@ -254,6 +453,50 @@ std::vector<unsigned> MainWindow::getTopologyFromUi() const {
     return topo;
 }
 
+std::vector<Activation> MainWindow::getActivationsFromUi(const size_t layerCount) const {
+    const auto hidden = static_cast<Activation>(m_hiddenActivationCombo->currentData().toInt());
+    const auto output = static_cast<Activation>(m_outputActivationCombo->currentData().toInt());
+    std::vector<Activation> activations;
+    for (size_t l = 1; l < layerCount; ++l) {
+        activations.push_back(l == layerCount - 1 ? output : hidden);
+    }
+    return activations;
+}
+
+bool MainWindow::netHasActivations(const std::vector<Activation> &activations) const {
+    for (size_t l = 1; l < m_net->getLayerCount(); ++l) {
+        if (m_net->getActivation(l) != activations[l - 1]) return false;
+    }
+    return true;
+}
+
+Optimizer MainWindow::getOptimizerFromUi() const {
+    const auto type = static_cast<OptimizerType>(m_optimizerCombo->currentData().toInt());
+    const double eta = m_etaSpin->value();
+    switch (type) {
+        case OptimizerType::Nesterov: return Optimizer::nesterov(eta, m_alphaSpin->value());
+        case OptimizerType::Adam: return Optimizer::adam(eta);
+        case OptimizerType::RMSProp: return Optimizer::rmsProp(eta);
+        case OptimizerType::Momentum: break;
+    }
+    return Optimizer::sgd(eta, m_alphaSpin->value());
+}
+
+LearningRateSchedule MainWindow::getScheduleFromUi() const {
+    const auto type = static_cast<ScheduleType>(m_scheduleCombo->currentData().toInt());
+    const auto warmup = static_cast<std::size_t>(m_warmupSpin->value());
+    switch (type) {
+        case ScheduleType::Step: {
+            const auto epochs = static_cast<std::size_t>(m_epochsSpin->value());
+            const std::size_t scheduled = epochs > warmup ? epochs - warmup : 1;
+            return LearningRateSchedule::step(std::max<std::size_t>(1, (scheduled + 2) / 3), 0.1, warmup);
+        }
+        case ScheduleType::Cosine: return LearningRateSchedule::cosine(0.0, warmup);
+        case ScheduleType::Constant: break;
+    }
+    return LearningRateSchedule::constant(warmup);
+}
+
 bool MainWindow::validateAndPrepareTraining() {
     const auto topology = getTopologyFromUi();
     if (topology.size() < 2) {
@@ -275,24 +518,60 @@ bool MainWindow::validateAndPrepareTraining() {
         return false;
     }
     try {
-        std::vector<unsigned> fileTopology;
-        if (TrainingData::peekTopology(path.toStdString(), fileTopology) &&
-            !fileTopology.empty() && (fileTopology[0] != topology[0] || fileTopology.back() != topology.back())) {
-            QMessageBox::StandardButton r = QMessageBox::question(this, tr("Topology Mismatch"),
-                tr("The training file's topology differs from yours. Continue anyway?"),
-                QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
-            if (r == QMessageBox::No) return false;
+        // the samples stay in memory between runs unless the file changed
+        const QFileInfo info(path);
+        const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+        if (!m_dataset || m_datasetPath != path || m_datasetModified != modified) {
+            m_dataset.reset();
+            m_statusLabel->setText(tr("Loading training data..."));
+            QApplication::processEvents();
+            m_dataset = std::make_unique<Dataset>(Dataset::load(path.toStdString()));
+            m_datasetPath = path;
+            m_datasetModified = modified;
+        }
+        if (m_dataset->getInputCount() != topology.front() || m_dataset->getTargetCount() != topology.back()) {
+            QMessageBox::warning(this, tr("Topology Mismatch"),
+                tr("The training file has %1 inputs and %2 outputs per sample, but the network has %3 and %4.")
+                    .arg(static_cast<qulonglong>(m_dataset->getInputCount()))
+                    .arg(static_cast<qulonglong>(m_dataset->getTargetCount()))
+                    .arg(topology.front()).arg(topology.back()));
+            m_statusLabel->setText(tr("Ready"));
+            return false;
+        }
+        if (m_dataset->getSampleCount() == 0) {
+            QMessageBox::warning(this, tr("Training"), tr("The training file contains no samples."));
+            m_statusLabel->setText(tr("Ready"));
+            return false;
+        }
+        // keep training the current network (e.g. a loaded model) if the controls still describe it
+        const std::vector<Activation> activations = getActivationsFromUi(topology.size());
+        if (m_net && m_net->getTopology() == topology && netHasActivations(activations)) {
+            Optimizer optimizer = getOptimizerFromUi();
+            const Optimizer &current = m_net->getOptimizer();
+            if (optimizer.type == current.type) {
+                // the controls only set the learning rate and momentum, the rest (Adam's betas, ...) stays
+                const Optimizer chosen = optimizer;
+                optimizer = current;
+                optimizer.learningRate = chosen.learningRate;
+                if (chosen.type == OptimizerType::Momentum || chosen.type == OptimizerType::Nesterov) {
+                    optimizer.momentum = chosen.momentum;
+                }
+            }
+            m_net->setOptimizer(optimizer); // the optimizer state survives unless the type changed
+            return true;
+        }
+        if (m_net && QMessageBox::question(this, tr("Training"),
+                tr("The topology or activations differ from the current network. "
+                   "Replace it with a new, untrained network?")) != QMessageBox::Yes) {
+            m_statusLabel->setText(tr("Ready"));
+            return false;
         }
-        m_trainingData = std::make_unique<TrainingData>(path.toStdString());
-        std::vector<unsigned> dummy;
-        m_trainingData->getTopology(dummy);
-        m_net = std::make_unique<Net>(topology);
-        Neuron::setEta(m_etaSpin->value());
-        Neuron::setAlpha(m_alphaSpin->value());
-        m_trainingData->reset();
+        m_net = std::make_unique<Net>(topology, activations);
+        m_net->setOptimizer(getOptimizerFromUi());
         return true;
     } catch (const std::exception &e) {
         QMessageBox::critical(this, tr("Error"), QString::fromStdString(e.what()));
+        m_statusLabel->setText(tr("Ready"));
         return false;
     }
 }
@@ -300,59 +579,108 @@ bool MainWindow::validateAndPrepareTraining() {
 void MainWindow::onTrain() {
     if (!validateAndPrepareTraining()) return;
 
-    const auto topology = getTopologyFromUi();
-    const int epochs = m_epochsSpin->value();
+    TrainingOptions options;
+    options.epochs = static_cast<std::size_t>(m_epochsSpin->value());
+    options.batchSize = static_cast<std::size_t>(m_batchSpin->value());
+    options.shuffle = m_shuffleCheck->isChecked();
+    options.threadCount = static_cast<unsigned>(m_threadsSpin->value());
+    options.hogwild = m_trainingModeCombo->currentIndex() == 1;
+    options.schedule = getScheduleFromUi();
+    options.patience = static_cast<std::size_t>(m_patienceSpin->value());
+    options.progressInterval = std::chrono::milliseconds(100);
+    const double validationFraction = m_validationSpin->value() / 100.0;
 
     refreshPredictInputs();
     refreshNetworkVisualization();
     m_trainButton->setEnabled(false);
     m_cancelButton->setEnabled(true);
     m_cancelTraining.store(false);
+    m_trainingSnapshot = std::make_shared<const Net>(*m_net);
     m_statusLabel->setText(tr("Training..."));
-
-    std::thread worker([this, topology, epochs]() {
-        int currentEpoch = 0;
-        std::vector<double> inputVals, targetVals, resultVals;
-        bool cancelled = false;
-
-        while (currentEpoch < epochs) {
-            if (m_cancelTraining.load()) {
-                cancelled = true;
-                break;
-            }
-
-            std::size_t count = m_trainingData->getNextInputs(inputVals);
-            if (count != static_cast<std::size_t>(topology[0])) {
-                currentEpoch++;
-                if (currentEpoch >= epochs) break;
-                m_trainingData->reset();
-                count = m_trainingData->getNextInputs(inputVals);
-                if (count != static_cast<std::size_t>(topology[0])) break;
-            }
-            m_net->feedForward(inputVals);
-            m_net->getResults(resultVals);
-            m_trainingData->getTargetOutputs(targetVals);
-            if (targetVals.size() == topology.back()) {
-                m_net->backPropagate(targetVals);
-            }
+    m_lossCurve->clear(options.epochs);
+    m_gradientLabel->clear();
+    m_lastValidatedEpoch = 0;
+    m_telemetryTimer->start();
+
+    // the previous run has already reported back (Train was disabled until then), its thread is done
+    if (m_trainingThread.joinable()) {
+        m_trainingThread.join();
+    }
+    m_trainingThread = std::thread([this, options, validationFraction]() {
+        // the held-out samples are the same in every run, so results can be compared
+        std::optional<std::pair<Dataset, Dataset>> split;
+        if (validationFraction > 0.0) {
+            split.emplace(m_dataset->split(validationFraction, 1));
         }
-
-        double finalError = m_net->getRecentAverageError();
-        QMetaObject::invokeMethod(this, [this, finalError, cancelled]() {
+        const SampleSource &training = split ? static_cast<const SampleSource &>(split->first) : *m_dataset;
+
+        // the callback runs on this thread between batches, so the probe sees a net nobody updates
+        GradientProbe<double> probe(training);
+        Trainer trainer(options);
+        trainer.setProgressCallback([this, &probe, samplesPerEpoch = training.getSampleCount()](const TrainingProgress &progress) {
+            TelemetrySample sample = TelemetrySample::fromProgress(progress, samplesPerEpoch);
+            probe.measure(*m_net, sample);
+            m_telemetry->push(sample); // dropped if the UI has fallen far behind
+        });
+        const TrainingResult result = trainer.train(*m_net, training, split ? &split->second : nullptr,
+                                                    &m_cancelTraining);
+
+        QMetaObject::invokeMethod(this, [this, result]() {
+            onDrainTelemetry(); // the final sample was queued before this
+            m_telemetryTimer->stop();
             m_trainButton->setEnabled(true);
             m_cancelButton->setEnabled(false);
-            if (cancelled) {
-                m_statusLabel->setText(tr("Training cancelled"));
-                m_errorLabel->setText(tr("Error at cancellation: %1").arg(finalError));
+            m_trainingSnapshot.reset();
+            const TrainingProgress &progress = result.progress;
+            const QString timing = tr("%1 s, %2 samples/s")
+                                       .arg(progress.seconds, 0, 'f', 2)
+                                       .arg(progress.samplesPerSecond(), 0, 'f', 0);
+            if (result.cancelled) {
+                m_statusLabel->setText(tr("Training cancelled (%1)").arg(timing));
+            } else if (result.stoppedEarly) {
+                m_statusLabel->setText(tr("Stopped early after %1 epochs (%2)")
+                                           .arg(static_cast<qulonglong>(progress.epoch)).arg(timing));
+            } else {
+                m_statusLabel->setText(tr("Training complete (%1)").arg(timing));
+            }
+            if (result.restoredBest) {
+                m_errorLabel->setText(tr("Validation error: %1 (best epoch %2)")
+                                          .arg(result.bestValidationError)
+                                          .arg(static_cast<qulonglong>(result.bestEpoch)));
+            } else if (result.cancelled) {
+                m_errorLabel->setText(tr("Error at cancellation: %1").arg(progress.error));
             } else {
-                m_statusLabel->setText(tr("Training complete"));
-                m_errorLabel->setText(tr("Final error: %1").arg(finalError));
+                m_errorLabel->setText(tr("Final error: %1").arg(progress.error));
             }
             refreshPredictInputs();
             refreshNetworkVisualization();
         }, Qt::QueuedConnection);
     });
-    worker.detach();
+}
+
+void MainWindow::onDrainTelemetry() {
+    TelemetrySample sample;
+    std::optional<TelemetrySample> latest;
+    while (m_telemetry->pop(sample)) {
+        m_lossCurve->addError(sample.epochs, sample.error);
+        if (sample.epoch > m_lastValidatedEpoch && sample.validationError > 0.0) {
+            m_lastValidatedEpoch = sample.epoch;
+            m_lossCurve->addValidationError(static_cast<double>(sample.epoch), sample.validationError);
+        }
+        latest = sample;
+    }
+    if (!latest || !m_trainingSnapshot || m_cancelTraining.load()) return; // nothing new, finished or cancelling
+
+    m_statusLabel->setText(tr("Training... epoch %1 of %2, %3 samples/s")
+                               .arg(static_cast<qulonglong>(std::min(latest->epoch + 1, latest->epochCount)))
+                               .arg(static_cast<qulonglong>(latest->epochCount))
+                               .arg(latest->samplesPerSecond, 0, 'f', 0));
+    m_errorLabel->setText(tr("Error: %1").arg(latest->error));
+    QStringList norms;
+    for (std::size_t l = 0; l < latest->layerCount; ++l) {
+        norms << tr("layer %1: %2").arg(static_cast<qulonglong>(l + 1)).arg(latest->gradientNorms[l], 0, 'g', 3);
+    }
+    m_gradientLabel->setText(tr("Gradient norms: %1").arg(norms.join(QStringLiteral(", "))));
 }
 
 void MainWindow::onCancelTraining() {
@@ -362,11 +690,8 @@ void MainWindow::onCancelTraining() {
 }
 
 void MainWindow::refreshNetworkVisualization() const {
-    if (m_net) {
-        m_networkScene->setNet(m_net.get());
-    } else {
-        m_networkScene->setNet(nullptr);
-    }
+    // while training, m_net's weights are being written; show the net as it was at the start
+    m_networkScene->setNet(m_trainingSnapshot ? m_trainingSnapshot.get() : m_net.get());
     QRectF bounds = m_networkScene->itemsBoundingRect();
     bounds.adjust(-50, -50, 50, 50);
     m_networkScene->setSceneRect(bounds);
@@ -379,14 +704,14 @@ void MainWindow::refreshPredictInputs() {
     m_inputSpins.clear();
     m_drawDigitButton->setEnabled(false);
     if (!m_net || m_net->getLayerCount() == 0) return;
-    const size_t numInputs = m_net->getLayer(0).size() - 1;  // exclude bias
+    const size_t numInputs = m_net->getInputCount();
     auto *layout = m_predictInputsContainer->layout();
     for (size_t i = 0; i < numInputs; ++i) {
         auto *spin = new QDoubleSpinBox(m_predictInputsContainer);
         spin->setRange(-10.0, 10.0);
         spin->setDecimals(4);
         spin->setSingleStep(0.1);
-        spin->setValue(m_net->getLayer(0)[i].getOutputVal());
+        spin->setValue(m_net->getActivations(0)[i]);
         spin->setPrefix(tr("In %1: ").arg(static_cast<int>(i) + 1));
         layout->addWidget(spin);
         m_inputSpins.push_back(spin);
@@ -396,6 +721,10 @@ void MainWindow::refreshPredictInputs() {
 }
 
 void MainWindow::onCreateNetwork() {
+    if (m_trainingSnapshot) {
+        QMessageBox::information(this, tr("Create Network"), tr("Please wait for training to finish."));
+        return;
+    }
     const auto topology = getTopologyFromUi();
     if (topology.size() < 2) {
         QMessageBox::warning(this, tr("Create Network"),
@@ -409,9 +738,8 @@ void MainWindow::onCreateNetwork() {
             return;
         }
     }
-    Neuron::setEta(m_etaSpin->value());
-    Neuron::setAlpha(m_alphaSpin->value());
-    m_net = std::make_unique<Net>(topology);
+    m_net = std::make_unique<Net>(topology, getActivationsFromUi(topology.size()));
+    m_net->setOptimizer(getOptimizerFromUi());
     refreshPredictInputs();
     refreshNetworkVisualization();
     m_statusLabel->setText(tr("Network created (untrained)"));
@@ -419,9 +747,9 @@ void MainWindow::onCreateNetwork() {
 
 void MainWindow::onInputNeuronClicked(size_t index) {
     if (!m_net || m_net->getLayerCount() == 0) return;
-    const size_t numInputs = m_net->getLayer(0).size() - 1;
+    const size_t numInputs = m_net->getInputCount();
     if (index >= numInputs) return;
-    double currentVal = m_net->getLayer(0)[index].getOutputVal();
+    double currentVal = m_net->getActivations(0)[index];
     bool ok;
     double newVal = QInputDialog::getDouble(this, tr("Set Input Value"),
         tr("Enter value for input neuron %1:").arg(static_cast<int>(index) + 1),
@@ -429,24 +757,26 @@ void MainWindow::onInputNeuronClicked(size_t index) {
     if (!ok) return;
     std::vector<double> inputVals;
     for (size_t i = 0; i < numInputs; ++i) {
-        inputVals.push_back(i == index ? newVal : m_net->getLayer(0)[i].getOutputVal());
+        inputVals.push_back(i == index ? newVal : m_net->getActivations(0)[i]);
     }
-    m_net->feedForward(inputVals);
     std::vector<double> resultVals;
-    m_net->getResults(resultVals);
-    QString outText = tr("Output: ");
-    for (size_t i = 0; i < resultVals.size(); ++i) {
-        if (i > 0) outText += QStringLiteral(", ");
-        outText += QString::number(resultVals[i], 'f', 4);
+    if (m_trainingSnapshot) {
+        // the trainer is writing the weights, ask the snapshot instead
+        resultVals = m_trainingSnapshot->predict(inputVals);
+        m_outputLabel->setText(tr("Output (before training): ") + formatResults(resultVals));
+        return;
     }
-    m_outputLabel->setText(outText);
+    m_net->feedForward(inputVals);
+    m_net->getResults(resultVals);
+    m_outputLabel->setText(tr("Output: ") + formatResults(resultVals));
     refreshPredictInputs();
     refreshNetworkVisualization();
 }
 
 void MainWindow::onDrawDigit() {
-    if (!m_net || m_net->getLayer(0).size() - 1 != 64) return;
-    auto *dialog = new DrawDigitDialog(m_net.get(), this);
+    if (!m_net || m_net->getInputCount() != 64) return;
+    auto snapshot = m_trainingSnapshot ? m_trainingSnapshot : std::make_shared<const Net>(*m_net);
+    auto *dialog = new DrawDigitDialog(std::move(snapshot), this);
     dialog->setAttribute(Qt::WA_DeleteOnClose);
     connect(dialog, &DrawDigitDialog::applyRequested, this, &MainWindow::onDrawDigitApply);
     connect(dialog, &DrawDigitDialog::applyRequested, dialog, [dialog]() { dialog->accept(); });
@@ -462,24 +792,33 @@ void MainWindow::onDrawDigitApply(const std::vector<double> &values) const {
     refreshNetworkVisualization();
 }
 
+QString MainWindow::formatResults(const std::vector<double> &resultVals) {
+    QString text;
+    for (size_t i = 0; i < resultVals.size(); ++i) {
+        if (i > 0) text += QStringLiteral(", ");
+        text += QString::number(resultVals[i], 'f', 4);
+    }
+    return text;
+}
+
 void MainWindow::onPredict() const {
     if (!m_net) return;
     std::vector<double> inputVals;
     for (auto *spin : m_inputSpins) {
         inputVals.push_back(spin->value());
     }
-    if (inputVals.size() != m_net->getLayer(0).size() - 1) {
+    if (inputVals.size() != m_net->getInputCount()) {
         m_outputLabel->setText(tr("Output: (input count mismatch)"));
         return;
     }
-    m_net->feedForward(inputVals);
     std::vector<double> resultVals;
-    m_net->getResults(resultVals);
-    QString outText = tr("Output: ");
-    for (size_t i = 0; i < resultVals.size(); ++i) {
-        if (i > 0) outText += QStringLiteral(", ");
-        outText += QString::number(resultVals[i], 'f', 4);
+    if (m_trainingSnapshot) {
+        resultVals = m_trainingSnapshot->predict(inputVals);
+        m_outputLabel->setText(tr("Output (before training): ") + formatResults(resultVals));
+        return;
     }
-    m_outputLabel->setText(outText);
+    m_net->feedForward(inputVals);
+    m_net->getResults(resultVals);
+    m_outputLabel->setText(tr("Output: ") + formatResults(resultVals));
     refreshNetworkVisualization();
 }
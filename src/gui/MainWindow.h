@@ -4,19 +4,27 @@
 #include <QMainWindow>
 #include <atomic>
 #include <memory>
+#include <thread>
 #include <vector>
+#include "Activation.h"
+#include "LearningRateSchedule.h"
+#include "Optimizer.h"
+#include "Telemetry.h"
 
-class Net;
 class NetworkScene;
+class LossCurveWidget;
 class DrawDigitDialog;
-class TrainingData;
+class Dataset;
 class QGraphicsView;
 class QSpinBox;
 class QDoubleSpinBox;
+class QComboBox;
+class QCheckBox;
 class QPushButton;
 class QLineEdit;
 class QLabel;
 class QListWidget;
+class QTimer;
 class QVBoxLayout;
 class QWidget;
 
@@ -39,15 +47,26 @@ private slots:
     void onInputNeuronClicked(size_t index);
     void onDrawDigit();
     void onDrawDigitApply(const std::vector<double> &values) const;
+    void onOpenModel();
+    void onSaveModel();
+    void onDrainTelemetry();
 
 private:
     QWidget *setupTopologyPanel(QWidget *parent);
     QWidget *setupTrainingPanel(QWidget *parent);
     void setupNetworkView(QWidget *parent);
+    QWidget *setupTelemetryPanel(QWidget *parent);
+    void setupMenus();
     void refreshNetworkVisualization() const;
     void refreshPredictInputs();
     [[nodiscard]] std::vector<unsigned> getTopologyFromUi() const;
+    [[nodiscard]] std::vector<Activation> getActivationsFromUi(size_t layerCount) const;
+    // whether m_net's layers use activations (as from getActivationsFromUi for its layer count)
+    [[nodiscard]] bool netHasActivations(const std::vector<Activation> &activations) const;
+    [[nodiscard]] Optimizer getOptimizerFromUi() const;
+    [[nodiscard]] LearningRateSchedule getScheduleFromUi() const;
     bool validateAndPrepareTraining();
+    static QString formatResults(const std::vector<double> &resultVals);
 
     QWidget *m_centralWidget;
     QVBoxLayout *m_mainLayout;
@@ -57,8 +76,19 @@ private:
     QLineEdit *m_trainingDataPath{};
     QListWidget *m_topologyList{};
     QSpinBox *m_epochsSpin{};
+    QComboBox *m_optimizerCombo{};
     QDoubleSpinBox *m_etaSpin{};
     QDoubleSpinBox *m_alphaSpin{};
+    QComboBox *m_scheduleCombo{};
+    QSpinBox *m_warmupSpin{};
+    QSpinBox *m_validationSpin{};
+    QSpinBox *m_patienceSpin{};
+    QComboBox *m_hiddenActivationCombo{};
+    QComboBox *m_outputActivationCombo{};
+    QSpinBox *m_batchSpin{};
+    QCheckBox *m_shuffleCheck{};
+    QSpinBox *m_threadsSpin{};
+    QComboBox *m_trainingModeCombo{};
     QPushButton *m_trainButton{};
     QPushButton *m_cancelButton{};
     QPushButton *m_browseButton{};
@@ -70,10 +100,20 @@ private:
     QLabel *m_outputLabel{};
     QWidget *m_predictInputsContainer{};
     std::vector<QDoubleSpinBox *> m_inputSpins;
+    LossCurveWidget *m_lossCurve{};
+    QLabel *m_gradientLabel{};
+    QTimer *m_telemetryTimer{};
 
     std::unique_ptr<Net> m_net;
-    std::unique_ptr<TrainingData> m_trainingData;
+    std::shared_ptr<const Net> m_trainingSnapshot; // the net as it was when training started, serves predictions meanwhile
+    std::unique_ptr<Dataset> m_dataset; // loaded once, reused while the file is unchanged
+    QString m_datasetPath;
+    qint64 m_datasetModified = 0;
     std::atomic<bool> m_cancelTraining{false};
+    std::thread m_trainingThread; // trains m_net on m_dataset; joined before the next run and on close
+    // metrics from the training thread (the only producer) to the UI thread, drained by m_telemetryTimer
+    std::unique_ptr<TelemetryRing> m_telemetry = std::make_unique<TelemetryRing>();
+    std::size_t m_lastValidatedEpoch = 0; // the validation curve gets one point per epoch
 };
 
 #endif // MAINWINDOW_H
@@ -1,11 +1,11 @@
 #include "NetworkScene.h"
 #include "NeuronItem.h"
 #include "Net.h"
-#include "Neuron.h"
 #include <QPen>
 #include <QBrush>
 #include <QColor>
 #include <QGraphicsLineItem>
+#include <span>
 #include <vector>
 
 namespace {
@@ -35,7 +35,7 @@ void NetworkScene::paintNetwork() {
     // Find max neurons in any layer for vertical centering
     size_t maxNeurons = 0;
     for (size_t l = 0; l < numLayers; ++l) {
-        size_t count = m_net->getLayer(l).size();
+        size_t count = m_net->getActivations(l).size() + 1;  // bias included
         if (count > maxNeurons) maxNeurons = count;
     }
 
@@ -43,20 +43,18 @@ void NetworkScene::paintNetwork() {
     double neuronSpacing =
         maxNeurons > 1 ? totalHeight / static_cast<double>(maxNeurons - 1) : 0.0;
 
-    // Get weight range for connection coloring
+    // Get weight range for connection coloring, reading the net's arrays in place
     double minWeight = 0, maxWeight = 0;
     bool firstWeight = true;
     for (size_t l = 0; l < numLayers - 1; ++l) {
-        const auto &layer = m_net->getLayer(l);
-        for (const auto & n : layer) {
-            const auto &weights = n.getOutputWeights();
-            for (const auto &conn : weights) {
+        for (const std::span<const double> weights : {m_net->getWeights(l), m_net->getBiases(l)}) {
+            for (const double w : weights) {
                 if (firstWeight) {
-                    minWeight = maxWeight = conn.weight;
+                    minWeight = maxWeight = w;
                     firstWeight = false;
                 } else {
-                    minWeight = qMin(minWeight, conn.weight);
-                    maxWeight = qMax(maxWeight, conn.weight);
+                    minWeight = qMin(minWeight, w);
+                    maxWeight = qMax(maxWeight, w);
                 }
             }
         }
@@ -68,7 +66,7 @@ void NetworkScene::paintNetwork() {
     std::vector<std::vector<Pos>> positions(numLayers);
 
     for (size_t l = 0; l < numLayers; ++l) {
-        size_t neuronCount = m_net->getLayer(l).size();
+        size_t neuronCount = m_net->getActivations(l).size() + 1;
         const double layerHeight =
             (neuronCount > 1) ? static_cast<double>(neuronCount - 1) * neuronSpacing : 0.0;
         const double startY = -layerHeight / 2.0;
@@ -82,13 +80,16 @@ void NetworkScene::paintNetwork() {
 
     // Draw connections first (behind neurons)
     for (size_t l = 0; l < numLayers - 1; ++l) {
-        const auto &layer = m_net->getLayer(l);
+        const std::span<const double> weights = m_net->getWeights(l);  // [next layer x this layer]
+        const std::span<const double> biases = m_net->getBiases(l);
+        const size_t numInputs = m_net->getActivations(l).size();
+        const size_t numOutputs = biases.size();
         const auto &nextPositions = positions[l + 1];
 
-        for (size_t n = 0; n < layer.size(); ++n) {
-            const auto &weights = layer[n].getOutputWeights();
-            for (size_t c = 0; c < weights.size() && c < nextPositions.size(); ++c) {
-                const double w = weights[c].weight;
+        // the last neuron is the bias, whose weights are the next layer's biases
+        for (size_t n = 0; n <= numInputs; ++n) {
+            for (size_t c = 0; c < numOutputs && c < nextPositions.size(); ++c) {
+                const double w = n < numInputs ? weights[c * numInputs + n] : biases[c];
                 const double t = (w - minWeight) / weightRange;
                 const int r = static_cast<int>(t * 255);
                 constexpr int g = 100;
@@ -110,13 +111,13 @@ void NetworkScene::paintNetwork() {
 
     // Draw neurons
     for (size_t l = 0; l < numLayers; ++l) {
-        const auto &layer = m_net->getLayer(l);
+        const std::span<const double> outputs = m_net->getActivations(l);
         bool isInput = (l == 0);
         bool isOutput = (l == numLayers - 1);
 
-        for (size_t n = 0; n < layer.size(); ++n) {
-            bool isBias = (n == layer.size() - 1);  // last neuron in each layer is bias
-            double outVal = layer[n].getOutputVal();
+        for (size_t n = 0; n <= outputs.size(); ++n) {
+            bool isBias = (n == outputs.size());  // last neuron in each layer is bias
+            double outVal = isBias ? 1.0 : outputs[n];
             QColor fillColor;
             if (isBias) {
                 fillColor = QColor(180, 180, 200);
@@ -125,7 +126,8 @@ void NetworkScene::paintNetwork() {
             } else if (isOutput) {
                 fillColor = QColor(255, 150, 100);
             } else {
-                double t = (outVal + 1.0) / 2.0;
+                // tanh range; ReLU/linear outputs can leave it
+                double t = qBound(0.0, (outVal + 1.0) / 2.0, 1.0);
                 fillColor = QColor(
                     static_cast<int>(255 * (1 - t)),
                     200,
@@ -3,7 +3,9 @@
 
 #include <QGraphicsScene>
 
-class Net;
+template<typename T>
+class BasicNet;
+using Net = BasicNet<double>;
 class NeuronItem;
 
 class NetworkScene : public QGraphicsScene {
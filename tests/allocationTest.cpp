@@ -0,0 +1,181 @@
+//
+// Checks that training and inference do not allocate once their buffers exist: replaces the
+// global operator new with a counting one and runs every hot path twice, the first time to warm
+// up (workspaces, thread-local buffers, the trainers' threads), the second time counting.
+//
+// Usage: ./AllocationTest     (exits with 1 if a path allocated)
+//
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <vector>
+#include "Dataset.h"
+#include "HogwildTrainer.h"
+#include "Net.h"
+#include "ParallelTrainer.h"
+#include "Trainer.h"
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+void *allocate(const std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *allocateAligned(std::size_t size, const std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    size = (size + align - 1) / align * align;
+#ifdef _WIN32
+    void *p = _aligned_malloc(size ? size : align, align);
+#else
+    void *p = std::aligned_alloc(align, size ? size : align);
+#endif
+    if (p) return p;
+    throw std::bad_alloc();
+}
+
+void freeAligned(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+}
+
+void *operator new(const std::size_t size) { return allocate(size); }
+void *operator new[](const std::size_t size) { return allocate(size); }
+void *operator new(const std::size_t size, const std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void *operator new[](const std::size_t size, const std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+
+namespace {
+
+constexpr std::size_t batchSize = 32;
+constexpr int iterations = 20;
+constexpr std::size_t datasetSize = 256;
+
+// runs pass once to warm up, then counts the allocations of the second run
+bool check(const char *precision, const char *name, const std::function<void()> &pass) {
+    pass();
+    const std::size_t before = allocations.load();
+    pass();
+    const std::size_t count = allocations.load() - before;
+    std::printf("%-7s %-30s %zu allocations\n", precision, name, count);
+    return count == 0;
+}
+
+// trains three epochs with options and counts the allocations of the last two; the first one
+// warms up (the trainer's threads and workspaces, the sample order)
+template<typename T>
+bool checkTrainer(const char *precision, const char *name, BasicNet<T> &net, const Dataset &dataset,
+                  const TrainingOptions &options) {
+    Trainer trainer(options);
+    std::size_t before = 0;
+    std::size_t count = 0;
+    trainer.setEpochCallback([&](const TrainingProgress &progress) {
+        if (progress.epoch == 1) {
+            before = allocations.load();
+        } else if (progress.epoch == options.epochs) {
+            count = allocations.load() - before;
+        }
+    });
+    (void) trainer.train(net, dataset);
+    std::printf("%-7s %-30s %zu allocations\n", precision, name, count);
+    return count == 0;
+}
+
+template<typename T>
+bool checkNet(const char *precision) {
+    BasicNet<T> net({64, 32, 10});
+    net.setOptimizer(Optimizer::adam());
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> value(0.0f, 1.0f);
+    std::vector<float> inputs(batchSize * 64), targets(batchSize * 10);
+    for (float &v : inputs) v = value(random);
+    for (float &v : targets) v = value(random) < 0.5f ? 0.0f : 1.0f;
+    const std::vector<T> predictInputs(inputs.begin(), inputs.end());
+    std::vector<T> outputs(batchSize * 10);
+    const std::vector<double> inputValues(64, 0.5), targetValues(10, 0.0);
+    typename BasicNet<T>::Workspace workspace;
+    ParallelTrainer trainer(4);
+
+    std::vector<float> datasetInputs(datasetSize * 64), datasetTargets(datasetSize * 10);
+    for (float &v : datasetInputs) v = value(random);
+    for (float &v : datasetTargets) v = value(random) < 0.5f ? 0.0f : 1.0f;
+    const Dataset dataset({64, 32, 10}, std::move(datasetInputs), std::move(datasetTargets));
+    std::vector<std::size_t> order;
+    dataset.sampleOrder(order, true, 1, 0);
+    HogwildTrainer hogwild(4);
+
+    bool ok = true;
+    ok &= check(precision, "Net::trainBatch", [&] {
+        for (int i = 0; i < iterations; ++i) {
+            net.trainBatch(inputs.data(), targets.data(), batchSize);
+            net.trainBatch(inputs.data(), targets.data(), batchSize / 4); // smaller batches reuse the room
+        }
+    });
+    ok &= check(precision, "Net::predict (workspace)", [&] {
+        for (int i = 0; i < iterations; ++i) {
+            net.predict(predictInputs.data(), batchSize, outputs.data(), workspace);
+        }
+    });
+    ok &= check(precision, "Net::predict (thread_local)", [&] {
+        for (int i = 0; i < iterations; ++i) {
+            net.predict(predictInputs.data(), batchSize, outputs.data());
+        }
+    });
+    ok &= check(precision, "feedForward/backPropagate", [&] {
+        for (int i = 0; i < iterations; ++i) {
+            net.feedForward(inputValues);
+            net.backPropagate(targetValues);
+        }
+    });
+    ok &= check(precision, "ParallelTrainer::trainBatch", [&] {
+        for (int i = 0; i < iterations; ++i) {
+            trainer.trainBatch(net, inputs.data(), targets.data(), batchSize);
+        }
+    });
+    ok &= check(precision, "HogwildTrainer::trainEpoch", [&] {
+        hogwild.trainEpoch(net, dataset, order, batchSize / 4);
+    });
+
+    TrainingOptions options;
+    options.epochs = 3;
+    options.batchSize = batchSize;
+    options.threadCount = 4;
+    ok &= checkTrainer(precision, "Trainer::train (epoch)", net, dataset, options);
+    options.hogwild = true;
+    options.batchSize = batchSize / 4;
+    ok &= checkTrainer(precision, "Trainer::train (Hogwild epoch)", net, dataset, options);
+    return ok;
+}
+
+}
+
+int main() {
+    bool ok = checkNet<double>("double");
+    ok &= checkNet<float>("float");
+    if (!ok) {
+        std::fprintf(stderr, "Steady-state training or inference allocated\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+//
+// Converts text training data (topology:/in:/out: lines) into the binary dataset format,
+// which TrainingData memory-maps instead of parsing.
+//
+// Usage:
+//   ./ConvertTrainingData data/digits.txt data/digits.bin          # float32 values
+//   ./ConvertTrainingData data/digits.txt data/digits.bin --f64    # float64 values
+//
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "BinaryDataset.h"
+#include "TrainingData.h"
+
+namespace {
+
+template<typename T>
+std::size_t convert(TrainingData &trainingData, const std::vector<unsigned> &topology, const std::string &output) {
+    std::vector<T> inputs, targets;
+    std::vector<double> inputVals, targetVals;
+    std::size_t samples = 0;
+    while (trainingData.getNextInputs(inputVals) == topology.front()) {
+        if (trainingData.getTargetOutputs(targetVals) != topology.back()) {
+            std::cerr << "Warning: sample " << samples + 1 << " has no matching out: line, stopping there" << std::endl;
+            break;
+        }
+        inputs.insert(inputs.end(), inputVals.begin(), inputVals.end());
+        targets.insert(targets.end(), targetVals.begin(), targetVals.end());
+        ++samples;
+    }
+    BinaryDataset::write(output, topology, samples, inputs.data(), targets.data());
+    return samples;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 4 || (argc == 4 && std::strcmp(argv[3], "--f64") != 0)) {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.bin> [--f64]" << std::endl;
+        return 1;
+    }
+    const bool doublePrecision = argc == 4;
+
+    try {
+        TrainingData trainingData(argv[1]);
+        std::vector<unsigned> topology;
+        trainingData.getTopology(topology);
+        if (topology.size() < 2) {
+            std::cerr << "Error: no topology line in " << argv[1] << std::endl;
+            return 1;
+        }
+
+        const std::size_t samples = doublePrecision
+            ? convert<double>(trainingData, topology, argv[2])
+            : convert<float>(trainingData, topology, argv[2]);
+        std::cerr << "Wrote " << samples << " samples to " << argv[2] << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
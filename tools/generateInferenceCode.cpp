@@ -0,0 +1,211 @@
+//
+// Generates a self-contained C++ header that predicts with a trained model, for embedding in
+// programs that should not depend on the core library.
+//
+// Usage:
+//   ./GenerateInferenceCode model.nnm digits > digitsModel.h            # float
+//   ./GenerateInferenceCode model.nnm digits --double > digitsModel.h   # double
+//
+// The header defines, in namespace <name>:
+//   inputCount, outputCount                        sizes of the input and output layer
+//   constexpr std::array<T, outputCount> predict(const std::array<T, inputCount> &inputs)
+// The parameters are constexpr arrays and the layers are written out one after another, each
+// with its transfer function inlined, so the compiler sees (and can optimize) the whole net at
+// once. The code has no data-dependent branches: the loops have constant trip counts and the
+// clamps of tanh and ReLU are selects. Results match Net::predict up to rounding.
+//
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Activation.h"
+#include "Net.h"
+
+namespace {
+
+constexpr std::size_t valuesPerLine = 6;
+
+// a literal that reads back as exactly the same value of the generated scalar type
+std::string literal(const double value, const bool doublePrecision) {
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    if (doublePrecision) {
+        out << std::scientific << std::setprecision(std::numeric_limits<double>::max_digits10 - 1) << value;
+    } else {
+        out << std::scientific << std::setprecision(std::numeric_limits<float>::max_digits10 - 1)
+            << static_cast<float>(value) << 'f';
+    }
+    return out.str();
+}
+
+void writeArray(std::ostream &out, const std::string &type, const std::string &name, const std::span<const double> values,
+                const bool doublePrecision) {
+    out << "inline constexpr std::array<" << type << ", " << values.size() << "> " << name << "{\n";
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        out << (i % valuesPerLine == 0 ? "    " : " ") << literal(values[i], doublePrecision) << ',';
+        if (i % valuesPerLine == valuesPerLine - 1 || i + 1 == values.size()) {
+            out << '\n';
+        }
+    }
+    out << "};\n";
+}
+
+void writeTanh(std::ostream &out, const std::string &type, const bool doublePrecision) {
+    out << "// tanh as a clamped rational function x * P(x^2) / Q(x^2), |error| < 4e-7\n"
+        << "constexpr " << type << " tanh(" << type << " x) {\n"
+        << "    const " << type << " limit = " << literal(tanhApproximation::limit, doublePrecision) << ";\n"
+        << "    x = x < -limit ? -limit : x;\n"
+        << "    x = x > limit ? limit : x;\n"
+        << "    const " << type << " x2 = x * x;\n"
+        << "    " << type << " p = " << literal(tanhApproximation::p[0], doublePrecision) << ";\n";
+    for (std::size_t k = 1; k < std::size(tanhApproximation::p); ++k) {
+        out << "    p = x2 * p + " << literal(tanhApproximation::p[k], doublePrecision) << ";\n";
+    }
+    out << "    " << type << " q = " << literal(tanhApproximation::q[0], doublePrecision) << ";\n";
+    for (std::size_t k = 1; k < std::size(tanhApproximation::q); ++k) {
+        out << "    q = x2 * q + " << literal(tanhApproximation::q[k], doublePrecision) << ";\n";
+    }
+    out << "    return x * p / q;\n"
+        << "}\n";
+}
+
+// the statement applying a transfer function to value v, empty for linear layers
+std::string activationStatement(const Activation activation, const bool doublePrecision) {
+    switch (activation) {
+        case Activation::Tanh:
+            return "v = detail::tanh(v);";
+        case Activation::Sigmoid: {
+            const std::string half = doublePrecision ? "0.5" : "0.5f";
+            return "v = " + half + " * detail::tanh(" + half + " * v) + " + half + ";";
+        }
+        case Activation::ReLU: {
+            const std::string zero = doublePrecision ? "0.0" : "0.0f";
+            return "v = v < " + zero + " ? " + zero + " : v;";
+        }
+        case Activation::Linear:
+            break;
+    }
+    return {};
+}
+
+void generate(std::ostream &out, const Net &net, const std::string &source, const std::string &name,
+              const bool doublePrecision) {
+    const std::string type = doublePrecision ? "double" : "float";
+    const vector<unsigned> topology = net.getTopology();
+
+    std::string guard;
+    for (const char c : name) {
+        guard += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    guard += "_MODEL_H";
+
+    std::string topologyText;
+    for (const unsigned count : topology) {
+        topologyText += (topologyText.empty() ? "" : " ") + std::to_string(count);
+    }
+
+    out << "//\n"
+        << "// Generated by GenerateInferenceCode from " << source << " (topology " << topologyText << ").\n"
+        << "// Do not edit; regenerate from the model instead.\n"
+        << "//\n\n"
+        << "#ifndef " << guard << "\n"
+        << "#define " << guard << "\n\n"
+        << "#include <array>\n"
+        << "#include <cstddef>\n\n"
+        << "namespace " << name << " {\n\n"
+        << "inline constexpr std::size_t inputCount = " << topology.front() << ";\n"
+        << "inline constexpr std::size_t outputCount = " << topology.back() << ";\n\n"
+        << "namespace detail {\n\n";
+    writeTanh(out, type, doublePrecision);
+
+    // weights input-major ([inputs x outputs]), so the inner loops run over the outputs
+    for (std::size_t l = 0; l + 1 < topology.size(); ++l) {
+        const DenseLayer<double> &layer = net.getDenseLayer(l);
+        const std::size_t numInputs = layer.getInputCount();
+        const std::size_t numOutputs = layer.getOutputCount();
+        std::vector<double> weights(numInputs * numOutputs);
+        for (std::size_t o = 0; o < numOutputs; ++o) {
+            for (std::size_t i = 0; i < numInputs; ++i) {
+                weights[i * numOutputs + o] = layer.getWeight(o, i);
+            }
+        }
+        out << "\n// layer " << l + 1 << ": " << numInputs << " -> " << numOutputs << ", "
+            << activationName(layer.getActivation()) << "\n";
+        writeArray(out, type, "weights" + std::to_string(l + 1), weights, doublePrecision);
+        writeArray(out, type, "biases" + std::to_string(l + 1), layer.getBiases(), doublePrecision);
+    }
+    out << "\n} // namespace detail\n\n";
+
+    out << "constexpr std::array<" << type << ", outputCount> predict(const std::array<" << type
+        << ", inputCount> &inputs) {\n";
+    std::string previous = "inputs";
+    for (std::size_t l = 0; l + 1 < topology.size(); ++l) {
+        const DenseLayer<double> &layer = net.getDenseLayer(l);
+        const std::string index = std::to_string(l + 1);
+        const std::string values = "layer" + index;
+        const std::string numOutputs = std::to_string(layer.getOutputCount());
+        const std::string statement = activationStatement(layer.getActivation(), doublePrecision);
+
+        out << (l == 0 ? "" : "\n")
+            << "    std::array<" << type << ", " << numOutputs << "> " << values << " = detail::biases" << index << ";\n"
+            << "    for (std::size_t i = 0; i < " << layer.getInputCount() << "; ++i) {\n"
+            << "        for (std::size_t o = 0; o < " << numOutputs << "; ++o) {\n"
+            << "            " << values << "[o] += detail::weights" << index << "[i * " << numOutputs << " + o] * "
+            << previous << "[i];\n"
+            << "        }\n"
+            << "    }\n";
+        if (!statement.empty()) {
+            out << "    for (" << type << " &v : " << values << ") {\n"
+                << "        " << statement << "\n"
+                << "    }\n";
+        }
+        previous = values;
+    }
+    out << "    return " << previous << ";\n"
+        << "}\n\n"
+        << "} // namespace " << name << "\n\n"
+        << "#endif // " << guard << "\n";
+}
+
+bool isIdentifier(const std::string &name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name.front()))) {
+        return false;
+    }
+    for (const char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 4 || (argc == 4 && std::strcmp(argv[3], "--double") != 0)) {
+        std::cerr << "Usage: " << argv[0] << " <model.nnm> <namespace> [--double] > header.h" << std::endl;
+        return 1;
+    }
+    const std::string name = argv[2];
+    if (!isIdentifier(name)) {
+        std::cerr << "Error: " << name << " is not a valid C++ namespace name" << std::endl;
+        return 1;
+    }
+
+    try {
+        const Net net = Net::load(argv[1]);
+        generate(std::cout, net, std::filesystem::path(argv[1]).filename().string(), name, argc == 4);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+//
+// Compares int8 inference (QuantizedNet) with float inference on a dataset: accuracy, agreement,
+// output error, parameter size and prediction time.
+//
+// Usage:
+//   ./QuantizationReport data/digits.txt                # trains a float net on 80%, reports on the rest
+//   ./QuantizationReport data/digits.txt model.nnm      # reports a saved model on the whole file
+//
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Dataset.h"
+#include "Kernels.h"
+#include "Net.h"
+#include "QuantizedNet.h"
+#include "Trainer.h"
+
+namespace {
+
+constexpr std::size_t trainingEpochs = 30;
+constexpr std::size_t trainingBatchSize = 16;
+constexpr std::uint64_t seed = 1;
+constexpr int timingRuns = 20;
+
+// the predicted class: the strongest output, or for a single output whether it is above 0.5
+std::size_t predictedClass(const float *values, const std::size_t count) {
+    if (count == 1) {
+        return values[0] > 0.5f ? 1 : 0;
+    }
+    return static_cast<std::size_t>(std::max_element(values, values + count) - values);
+}
+
+FloatNet train(const Dataset &dataset) {
+    FloatNet net(dataset.getTopology());
+    TrainingOptions options;
+    options.epochs = trainingEpochs;
+    options.batchSize = trainingBatchSize;
+    options.seed = seed;
+    Trainer(options).train(net, dataset);
+    return net;
+}
+
+// seconds per sample, predicting one sample at a time like a serving process would
+template<typename Model>
+double timePerSample(const Model &model, const Dataset &dataset) {
+    std::vector<float> outputs(dataset.getTargetCount());
+    double best = 0.0;
+    for (int run = 0; run < timingRuns; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t s = 0; s < dataset.getSampleCount(); ++s) {
+            model.predict(dataset.getInputs(s), 1, outputs.data());
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = run == 0 ? seconds : std::min(best, seconds);
+    }
+    return best / static_cast<double>(dataset.getSampleCount());
+}
+
+void report(const FloatNet &net, const Dataset &dataset) {
+    const QuantizedNet quantized(net);
+    const std::size_t samples = dataset.getSampleCount();
+    const std::size_t numOutputs = dataset.getTargetCount();
+
+    std::vector<float> floatOutputs(samples * numOutputs);
+    std::vector<float> int8Outputs(samples * numOutputs);
+    net.predict(dataset.getInputs(), samples, floatOutputs.data());
+    quantized.predict(dataset.getInputs(), samples, int8Outputs.data());
+
+    std::size_t floatCorrect = 0, int8Correct = 0, agree = 0;
+    double maxError = 0.0, sumError = 0.0;
+    for (std::size_t s = 0; s < samples; ++s) {
+        const float *f = floatOutputs.data() + s * numOutputs;
+        const float *q = int8Outputs.data() + s * numOutputs;
+        const std::size_t expected = predictedClass(dataset.getTargets(s), numOutputs);
+        floatCorrect += predictedClass(f, numOutputs) == expected;
+        int8Correct += predictedClass(q, numOutputs) == expected;
+        agree += predictedClass(f, numOutputs) == predictedClass(q, numOutputs);
+        for (std::size_t o = 0; o < numOutputs; ++o) {
+            const double error = std::abs(static_cast<double>(f[o]) - static_cast<double>(q[o]));
+            maxError = std::max(maxError, error);
+            sumError += error;
+        }
+    }
+
+    std::size_t floatBytes = 0;
+    for (std::size_t l = 0; l + 1 < net.getLayerCount(); ++l) {
+        const DenseLayer<float> &layer = net.getDenseLayer(l);
+        floatBytes += (layer.getWeights().size() + layer.getBiases().size()) * sizeof(float);
+    }
+
+    const auto percent = [samples](const std::size_t count) {
+        return 100.0 * static_cast<double>(count) / static_cast<double>(samples);
+    };
+    const double floatTime = timePerSample(net, dataset);
+    const double int8Time = timePerSample(quantized, dataset);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Samples:           " << samples << "\n"
+              << "Kernels:           float " << kernels::activeIsa() << ", int8 " << kernels::activeInt8Isa() << "\n"
+              << "Accuracy float32:  " << floatCorrect << " (" << percent(floatCorrect) << "%)\n"
+              << "Accuracy int8:     " << int8Correct << " (" << percent(int8Correct) << "%)\n"
+              << "Same prediction:   " << agree << " (" << percent(agree) << "%)\n"
+              << std::setprecision(5)
+              << "Output error:      max " << maxError << ", mean "
+              << sumError / static_cast<double>(samples * numOutputs) << "\n"
+              << "Parameters:        float32 " << floatBytes << " bytes, int8 " << quantized.getParameterBytes()
+              << " bytes\n"
+              << std::setprecision(3)
+              << "Time per sample:   float32 " << floatTime * 1e6 << " us, int8 " << int8Time * 1e6 << " us"
+              << std::endl;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <data file> [model.nnm]" << std::endl;
+        return 1;
+    }
+
+    try {
+        const Dataset dataset = Dataset::load(argv[1]);
+        if (dataset.getSampleCount() == 0) {
+            std::cerr << "Error: no samples in " << argv[1] << std::endl;
+            return 1;
+        }
+
+        if (argc == 3) {
+            const FloatNet net = FloatNet::load(argv[2]);
+            if (net.getInputCount() != dataset.getInputCount() || net.getOutputCount() != dataset.getTargetCount()) {
+                std::cerr << "Error: the model does not match the topology of " << argv[1] << std::endl;
+                return 1;
+            }
+            report(net, dataset);
+        } else {
+            const auto [training, validation] = dataset.split(0.2, seed);
+            std::cerr << "Training on " << training.getSampleCount() << " samples..." << std::endl;
+            report(train(training), validation);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}